@@ -206,12 +206,25 @@ createScene()
   TriangleMesh* s = MeshSweeper::makeSphere();
 
   scene = new Scene("test");
-  scene->addActor(newActor(s, vec3(-3, -3, 0), vec3(1, 1, 1), Color::yellow));
-  scene->addActor(newActor(s, vec3(+3, -3, 0), vec3(2, 1, 1), Color::green));
-  scene->addActor(newActor(s, vec3(+3, +3, 0), vec3(1, 2, 1), Color::red));
-  scene->addActor(newActor(s, vec3(-3, +3, 0), vec3(1, 1, 2), Color::blue));
-  s = MeshReader().execute("f-16.obj");
-  scene->addActor(newActor(s, vec3(2, -4, -10)));
+  if (s != 0)
+  {
+    scene->addActor(newActor(s, vec3(-3, -3, 0), vec3(1, 1, 1), Color::yellow));
+    scene->addActor(newActor(s, vec3(+3, -3, 0), vec3(2, 1, 1), Color::green));
+    scene->addActor(newActor(s, vec3(+3, +3, 0), vec3(1, 2, 1), Color::red));
+    scene->addActor(newActor(s, vec3(-3, +3, 0), vec3(1, 1, 2), Color::blue));
+  }
+  if ((s = MeshReader().execute("f-16.obj")) == 0)
+  {
+    puts("Could not read f-16.obj");
+    return;
+  }
+  s->buildMeshlets();
+
+  Actor* f16 = newActor(s, vec3(2, -4, -10));
+  const REAL lodRatios[] = {(REAL)0.5, (REAL)0.25, (REAL)0.1};
+
+  ((TriangleMeshShape*)f16->getModel())->makeLODs(lodRatios, 3);
+  scene->addActor(f16);
 }
 
 int
@@ -232,6 +245,7 @@ main(int argc, char **argv)
   // create the renderer
   renderer = new GLRenderer(*scene);
   renderer->renderMode = GLRenderer::Smooth;
+  renderer->flags.set(GLRenderer::CullMeshlets);
   glutMainLoop();
   return 0;
 }
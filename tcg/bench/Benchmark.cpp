@@ -0,0 +1,364 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: Benchmark.cpp
+//  ========
+//  Microbenchmarks of the math, mesh, and container hot paths.
+//
+//  Usage: bench [OBJ file [JSON file]]
+//  Each benchmark runs a warm-up pass and then SAMPLES timed passes;
+//  the results (seconds per pass, percentiles, and items per second
+//  at the median) are written as JSON, by default to benchmark.json,
+//  so that runs can be compared over time. SAMPLES is large enough
+//  for the 99th percentile to leave out the two slowest passes,
+//  which are reported as the maximum.
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Array.h"
+#include "List.h"
+#include "Math/BatchTransform.h"
+#include "MeshReader.h"
+#include "MeshSweeper.h"
+
+#define SAMPLES 201
+#define N       65536
+
+using namespace Graphics;
+using namespace System::Collections;
+
+struct Result
+{
+  const char* name;
+  int items;
+  double min;
+  double p50;
+  double p90;
+  double p99;
+  double max;
+  double mean;
+
+}; // Result
+
+Array<Result> results(64);
+
+// Results are accumulated here, so that the timed code is not
+// optimized away
+volatile REAL sink;
+
+//
+// Auxiliary functions
+//
+inline int
+compareTimes(const void* a, const void* b)
+{
+  double d = *(const double*)a - *(const double*)b;
+  return d < 0 ? -1 : d > 0;
+}
+
+inline double
+percentile(const double* t, int n, double p)
+{
+  return t[int(p * (n - 1) + 0.5)];
+}
+
+template <typename F>
+void
+bench(const char* name, int items, F f)
+{
+  double t[SAMPLES];
+  Result r;
+
+  f();
+  for (int i = 0; i < SAMPLES; i++)
+  {
+    double s = omp_get_wtime();
+
+    f();
+    t[i] = omp_get_wtime() - s;
+  }
+  qsort(t, SAMPLES, sizeof(double), compareTimes);
+  r.name = name;
+  r.items = items;
+  r.min = t[0];
+  r.p50 = percentile(t, SAMPLES, 0.5);
+  r.p90 = percentile(t, SAMPLES, 0.9);
+  r.p99 = percentile(t, SAMPLES, 0.99);
+  r.max = t[SAMPLES - 1];
+  r.mean = 0;
+  for (int i = 0; i < SAMPLES; i++)
+    r.mean += t[i];
+  r.mean /= SAMPLES;
+  results.add(r);
+  printf("%-36s %12.0f items/s  p50 %10.3f ms  p99 %10.3f ms\n",
+    name,
+    items / r.p50,
+    r.p50 * 1e3,
+    r.p99 * 1e3);
+}
+
+inline REAL
+random(REAL a, REAL b)
+{
+  return a + (b - a) * REAL(rand()) / RAND_MAX;
+}
+
+inline vec3
+randomPoint()
+{
+  return vec3(random(-10, 10), random(-10, 10), random(-10, 10));
+}
+
+inline mat4
+randomMatrix()
+{
+  vec3 angles(random(0, 360), random(0, 360), random(0, 360));
+  return mat4::TRS(randomPoint(), angles, vec3(random(0.5, 2)));
+}
+
+bool
+writeResults(const char* fileName)
+{
+  FILE* file = fopen(fileName, "w");
+
+  if (file == 0)
+    return false;
+  fprintf(file, "{\n  \"real\": \"%s\",\n", sizeof(REAL) == 4 ? "float" : "double");
+  fprintf(file, "  \"threads\": %d,\n", omp_get_max_threads());
+  fprintf(file, "  \"samples\": %d,\n  \"benchmarks\": [\n", SAMPLES);
+  for (int i = 0, n = results.size(); i < n; i++)
+  {
+    const Result& r = results[i];
+
+    fprintf(file, "    {\"name\": \"%s\", \"items\": %d, ", r.name, r.items);
+    fprintf(file, "\"throughput\": %.6g, ", r.items / r.p50);
+    fprintf(file, "\"min\": %.6g, \"p50\": %.6g, \"p90\": %.6g, ",
+      r.min,
+      r.p50,
+      r.p90);
+    fprintf(file, "\"p99\": %.6g, \"max\": %.6g, \"mean\": %.6g}%s\n",
+      r.p99,
+      r.max,
+      r.mean,
+      i < n - 1 ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+  return true;
+}
+
+//
+// Benchmarks
+//
+void
+benchMath()
+{
+  const int nm = 1024;
+  mat4* a = new mat4[nm];
+  mat4* b = new mat4[nm];
+  mat4* c = new mat4[nm];
+  vec3* p = new vec3[N];
+  vec3* q = new vec3[N];
+  quat* r = new quat[N];
+
+  for (int i = 0; i < nm; i++)
+  {
+    a[i] = randomMatrix();
+    b[i] = randomMatrix();
+  }
+  for (int i = 0; i < N; i++)
+  {
+    p[i] = randomPoint();
+    r[i] = quat::eulerAngles(randomPoint() * 18);
+  }
+
+  mat4 m = randomMatrix();
+
+  bench("Matrix4x4::operator *", nm * 64, [&]()
+  {
+    for (int k = 0; k < 64; k++)
+      for (int i = 0; i < nm; i++)
+        c[i] = a[i] * b[(i + k) & (nm - 1)];
+    sink = c[nm - 1][3].x;
+  });
+  bench("Matrix4x4::transform3x4", N, [&]()
+  {
+    for (int i = 0; i < N; i++)
+      q[i] = m.transform3x4(p[i]);
+    sink = q[N - 1].x;
+  });
+  bench("transformPoints", N, [&]()
+  {
+    transformPoints(m, p, q, N, false);
+    sink = q[N - 1].x;
+  });
+  bench("Quaternion::operator *", N, [&]()
+  {
+    quat s = r[0];
+
+    for (int i = 1; i < N; i++)
+      s = (s * r[i]).normalize();
+    sink = s.x;
+  });
+  bench("Quaternion::rotate", N, [&]()
+  {
+    for (int i = 0; i < N; i++)
+      q[i] = r[i].rotate(p[i]);
+    sink = q[N - 1].x;
+  });
+  bench("Bounds3::inflate", N, [&]()
+  {
+    Bounds3 box;
+
+    for (int i = 0; i < N; i++)
+      box.inflate(p[i]);
+    sink = box.getMax().x;
+  });
+  bench("Bounds3::transform", nm * 64, [&]()
+  {
+    Bounds3 box(vec3(-1, -2, -3), vec3(3, 2, 1));
+    Bounds3 t;
+
+    for (int k = 0; k < 64; k++)
+      for (int i = 0; i < nm; i++)
+        t.inflate(Bounds3(box, a[i]));
+    sink = t.getMax().x;
+  });
+  delete []r;
+  delete []q;
+  delete []p;
+  delete []c;
+  delete []b;
+  delete []a;
+}
+
+void
+benchMesh(TriangleMesh* mesh)
+{
+  int nt = mesh->getData().numberOfTriangles;
+  int nv = mesh->getData().numberOfVertices;
+
+  bench("TriangleMesh::computeNormals", nt, [&]()
+  {
+    mesh->computeNormals();
+    sink = mesh->getData().normals[0].x;
+  });
+  bench("TriangleMesh::computeNormals+angle", nt, [&]()
+  {
+    mesh->computeNormals(TriangleMesh::AngleWeighting);
+    sink = mesh->getData().normals[0].x;
+  });
+  bench("TriangleMesh::boundingBox", nv, [&]()
+  {
+    sink = mesh->boundingBox().getMax().x;
+  });
+}
+
+void
+benchSweeper()
+{
+  static const char* names[] =
+  {
+    "MeshSweeper::makeSphere/16",
+    "MeshSweeper::makeSphere/64",
+    "MeshSweeper::makeSphere/256"
+  };
+  static const int mers[] = {16, 64, 256};
+
+  for (int i = 0; i < 3; i++)
+  {
+    int m = mers[i];
+
+    bench(names[i], 2 * m * m, [&]()
+    {
+      TriangleMesh* mesh = MeshSweeper::makeSphere(vec3(0, 0, 0), 1, m);
+
+      sink = mesh->getData().vertices[0].x;
+      delete mesh;
+    });
+  }
+  bench("Sweeper::makeCircle+normal", 1024 * 256, [&]()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      Sweeper::Polyline circle =
+        Sweeper::makeCircle(vec3(0, 0, 0), 1, vec3(0, 0, 1), 1024);
+
+      sink = circle.normal().z;
+    }
+  });
+}
+
+void
+benchArray()
+{
+  bench("Array::add", N, [&]()
+  {
+    Array<int> a;
+
+    for (int i = 0; i < N; i++)
+      a.add(i);
+    sink = REAL(a[N - 1]);
+  });
+  bench("List::add", N, [&]()
+  {
+    List<int> l;
+
+    for (int i = 0; i < N; i++)
+      l.add(i);
+    sink = REAL(l.size());
+  });
+}
+
+//
+// Main function
+//
+int
+main(int argc, char** argv)
+{
+  const char* objFile = argc > 1 ? argv[1] : "f-16.obj";
+  const char* jsonFile = argc > 2 ? argv[2] : "benchmark.json";
+
+  srand(1);
+  benchMath();
+
+  TriangleMesh* mesh = MeshReader().execute(objFile);
+
+  if (mesh != 0)
+  {
+    bench("MeshReader::execute", mesh->getData().numberOfTriangles, [&]()
+    {
+      TriangleMesh* m = MeshReader().execute(objFile);
+
+      sink = m->getData().vertices[0].x;
+      delete m;
+    });
+    benchMesh(mesh);
+    delete mesh;
+  }
+  else
+  {
+    // Without the OBJ file, the mesh benchmarks run on a sphere
+    printf("Could not read %s; using a sphere\n", objFile);
+    mesh = MeshSweeper::makeSphere(vec3(0, 0, 0), 1, 128);
+    benchMesh(mesh);
+    delete mesh;
+  }
+  benchSweeper();
+  benchArray();
+  if (!writeResults(jsonFile))
+  {
+    printf("Could not write %s\n", jsonFile);
+    return 1;
+  }
+  printf("Results written to %s\n", jsonFile);
+  return 0;
+}
@@ -15,6 +15,7 @@
 //  ========
 //  Class definition for actor.
 
+#include "Camera.h"
 #include "Core/Flags.h"
 #include "List.h"
 #include "Model.h"
@@ -38,17 +39,28 @@ public:
   enum
   {
     Visible = 1,
-    Dynamic = 2
+    Dynamic = 2,
+    Occluder = 4
   };
 
+  // Flags set directly are refreshed in the actor table of the
+  // scene after modified()
   Flags flags;
 
   // Constructor
   Actor(Model& aModel):
     flags(Visible),
-    model(&aModel)
+    model(&aModel),
+    lod(0),
+    index(-1)
   {
-    // do nothing
+    aModel.actors.add(this);
+  }
+
+  // Destructor
+  ~Actor()
+  {
+    model->actors.remove(this);
   }
 
   bool isVisible() const
@@ -59,6 +71,7 @@ public:
   void setVisible(bool state)
   {
     flags.enable(Visible, state);
+    modified();
   }
 
   bool isDynamic() const
@@ -69,6 +82,20 @@ public:
   void setDynamic(bool state)
   {
     flags.enable(Dynamic, state);
+    modified();
+  }
+
+  bool isOccluder() const
+  {
+    return flags.isSet(Occluder);
+  }
+
+  // Occluders are drawn into the depth buffer of the occlusion
+  // culler of a renderer; they should be large and simple
+  void setOccluder(bool state)
+  {
+    flags.enable(Occluder, state);
+    modified();
   }
 
   Model* getModel() const
@@ -78,14 +105,46 @@ public:
 
   void setModel(Model& model)
   {
+    this->model->actors.remove(this);
+    model.actors.add(this);
     this->model = &model;
+    lod = 0;
+    modified();
+  }
+
+  int getLOD() const
+  {
+    return lod;
+  }
+
+  Actor* getParent() const
+  {
+    return parent;
   }
 
+  // Set the parent of this actor, relative to which the matrix of
+  // its model is given; the parent must be an actor of the same
+  // scene, or it is ignored. Return false if the parent would be
+  // a descendant of this actor
+  bool setParent(Actor*);
+
+  int selectLOD(const Camera&, REAL);
+  // Select the LOD given the (world) bounds of the model
+  int selectLOD(const Camera&, REAL, const Bounds3&);
+
+  // Queue the row of this actor in the actor table of its scene
+  // to be refreshed by the next update of the scene
+  void modified();
+
 protected:
   ObjectPtr<Model> model;
+  ObjectPtr<Actor> parent;
+  int lod;
+  int index; // row in the actor table of the scene
 
   DECLARE_LIST_ELEMENT(Actor);
 
+  friend class ActorTable;
   friend class Scene;
 
 }; // Actor
@@ -93,6 +152,39 @@ protected:
 typedef ListImp<Actor> Actors;
 typedef ListIteratorImp<Actor> ActorIterator;
 
+
+//////////////////////////////////////////////////////////
+//
+// Actor inline implementation
+// =====
+inline int
+Actor::selectLOD(const Camera& camera, REAL maxError)
+{
+  return selectLOD(camera, maxError, model->boundingBox());
+}
+
+inline int
+Actor::selectLOD(const Camera& camera, REAL maxError, const Bounds3& bounds)
+{
+  // Choose the coarsest LOD whose error, relative to the window
+  // height, does not exceed maxError
+  int n = model->getNumberOfLODs();
+
+  lod = 0;
+  if (n > 1)
+  {
+    REAL size = camera.projectedSize(bounds);
+
+    for (int i = n - 1; i > 0; i--)
+      if (model->lodError(i) * size <= maxError)
+      {
+        lod = i;
+        break;
+      }
+  }
+  return lod;
+}
+
 } // end namespace Graphics
 
 #endif // __Actor_h
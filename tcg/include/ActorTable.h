@@ -0,0 +1,212 @@
+#ifndef __ActorTable_h
+#define __ActorTable_h
+
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: ActorTable.h
+//  ========
+//  Class definition for packed actor table.
+
+#include "Actor.h"
+#include "Array.h"
+#include "Geometry/AABBTree.h"
+#include "Geometry/BoundsTree.h"
+
+namespace Graphics
+{ // begin namespace Graphics
+
+
+//////////////////////////////////////////////////////////
+//
+// ActorTable: packed actor table class
+// ==========
+//
+// The rows of the table are the actors of a scene, stored as
+// parallel arrays of flags, world matrices, world bounds, meshes
+// (of LOD 0), and material IDs, so that per-frame passes such as
+// culling and draw-list building stream through contiguous memory.
+// The row of an actor is refreshed when the actor is added. An
+// actor modified through its interface (e.g., Actor::setModel()),
+// or whose model is modified (i.e., the matrix or material of the
+// model is set), queues its row, and update() refreshes only the
+// queued rows. The rows of dynamic actors, whose models may change
+// otherwise, are kept in a list of their own and refreshed by every
+// update(). The world bounds
+// are the leaves of a bounds tree, whose root is the union of the
+// bounds of all actors; refreshing or removing a row costs O(log n).
+//
+// The matrix of the model of an actor is relative to the parent of
+// the actor (see Actor::setParent()). A refreshed row is dirty, and
+// so are the rows of its descendants; update() recomputes the world
+// matrices and bounds of the dirty rows level by level, from the
+// roots down, with the rows of a level in parallel. The descendants
+// are found through the children of each row, so that the cost is
+// proportional to the number of dirty rows.
+//
+// The world bounds are also indexed by a dynamic AABB tree, which
+// answers box, sphere, frustum, and ray queries in sublinear time.
+//
+class ActorTable
+{
+public:
+  // Constructor
+  ActorTable():
+    height(0),
+    modifiedHierarchy(false),
+    modifiedDynamics(false)
+  {
+    // do nothing
+  }
+
+  int size() const
+  {
+    return actors.size();
+  }
+
+  Actor* getActor(int i) const
+  {
+    return actors[i];
+  }
+
+  const Flags* getFlags() const
+  {
+    return flags.getData();
+  }
+
+  // World matrices
+  const mat4* getMatrices() const
+  {
+    return matrices.getData();
+  }
+
+  // World normal matrices
+  const mat3* getNormalMatrices() const
+  {
+    return normalMatrices.getData();
+  }
+
+  const Bounds3* getBounds() const
+  {
+    return bounds.getBoxes();
+  }
+
+  // Union of the world bounds of all actors
+  const Bounds3& boundingBox() const
+  {
+    return bounds.getBounds();
+  }
+
+  const TriangleMesh* const* getMeshes() const
+  {
+    return meshes.getData();
+  }
+
+  const int* getMaterialIds() const
+  {
+    return materialIds.getData();
+  }
+
+  // Materials are given IDs as they appear and are kept until
+  // the table is cleared
+  const Material* getMaterial(int id) const
+  {
+    return materials[id];
+  }
+
+  int getNumberOfMaterials() const
+  {
+    return materials.size();
+  }
+
+  void add(Actor*);
+  void remove(Actor*);
+  void clear();
+
+  // Add to rows the rows whose world bounds overlap a box or a
+  // sphere, are not outside a frustum, or are hit by a ray; return
+  // the number of rows added
+  int findRows(const Bounds3&, Array<int>&) const;
+  int findRows(const vec3&, REAL, Array<int>&) const;
+  int findRows(const Frustum&, Array<int>&) const;
+  int findRows(const Ray&, Array<int>&) const;
+
+  // Return the row whose world bounds are hit first by a ray, or -1
+  int pick(const Ray&, REAL&) const;
+
+  // Refresh a row
+  void update(int);
+  // Queue a row to be refreshed by the next update()
+  void invalidate(int);
+  // Refresh the queued rows and the rows of dynamic actors, and
+  // then the world transforms of the dirty rows; return the number
+  // of rows refreshed
+  int update();
+
+private:
+  // Transform of a row relative to its parent row (or to the world,
+  // if the parent is -1)
+  struct Node
+  {
+    mat4 matrix;
+    mat3 normalMatrix;
+    Bounds3 bounds;
+    int parent;
+
+  }; // Node
+
+  Array<Actor*> actors;
+  Array<Flags> flags;
+  Array<Node> nodes;
+  Array<mat4> matrices;
+  Array<mat3> normalMatrices;
+  BoundsTree bounds;
+  Array<int> proxies; // leaves of the AABB tree
+  Array<const TriangleMesh*> meshes;
+  Array<int> materialIds;
+  Array<bool> queued; // rows in modifiedRows
+  Array<int> modifiedRows;
+  Array<int> dynamicRows;
+  Array<bool> dirty;
+  Array<int> dirtyRows;
+  Array<ObjectPtr<Material> > materials;
+  AABBTree tree;
+  // Level (number of ancestors) of each row, and children of each
+  // row; the children of row i are children[firstChild[i]..
+  // firstChild[i + 1])
+  Array<int> depths;
+  Array<int> children;
+  Array<int> firstChild;
+  int height; // number of levels
+  // Dirty rows and their descendants, and the same rows sorted by
+  // level; the rows of level l are order[levels[l]..levels[l + 1])
+  Array<int> subtree;
+  Array<int> order;
+  Array<int> levels;
+  bool modifiedHierarchy;
+  bool modifiedDynamics;
+
+  ActorTable(const ActorTable&);
+  ActorTable& operator =(const ActorTable&);
+
+  int materialId(const Material*);
+  int parentRow(int) const;
+  void setDirty(int);
+  void transform(int, int);
+  void updateProxy(int);
+  void updateDynamics();
+  void updateLevels();
+  void updateTransforms();
+
+}; // ActorTable
+
+} // end namespace Graphics
+
+#endif // __ActorTable_h
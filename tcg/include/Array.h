@@ -16,6 +16,9 @@
 // Class definition for generic array.
 
 #include <memory.h>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "Exception.h"
 
 namespace System
@@ -33,26 +36,115 @@ template <typename T> class Array;
 template <typename T> class ArrayIterator;
 template <typename T> class PointerArray;
 template <typename T> class PointerArrayIterator;
+template <typename T, int N> class SmallArray;
+template <typename T, int N> class SmallArrayIterator;
+
+
+//////////////////////////////////////////////////////////
+//
+// ArrayElements: element operations of Array
+// =============
+//
+// The storage of an array is raw memory in which only the first
+// size() elements are constructed. Elements are moved (and the
+// moved-from ones destroyed) when the storage grows or elements
+// are inserted or removed; trivially copyable elements are just
+// memcpy'ed/memmove'd.
+template <typename T, bool = std::is_trivially_copyable<T>::value>
+struct ArrayElements
+{
+  // Move n elements from src to the raw memory dst
+  static void relocate(T* dst, T* src, int n)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+
+  // Move p[0..n) to p[1..n]; p[0] is left raw
+  static void shiftUp(T* p, int n)
+  {
+    if (n == 0)
+      return;
+    new (p + n) T(std::move(p[n - 1]));
+    for (int i = n - 1; i > 0; i--)
+      p[i] = std::move(p[i - 1]);
+    p[0].~T();
+  }
+
+  // Move p[1..n] to p[0..n); p[0] must be raw and p[n] is left raw
+  static void shiftDown(T* p, int n)
+  {
+    if (n == 0)
+      return;
+    new (p) T(std::move(p[1]));
+    for (int i = 1; i < n; i++)
+      p[i] = std::move(p[i + 1]);
+    p[n].~T();
+  }
+
+  static void destroy(T* p, int n)
+  {
+    for (int i = 0; i < n; i++)
+      p[i].~T();
+  }
+
+}; // ArrayElements
+
+template <typename T>
+struct ArrayElements<T, true>
+{
+  static void relocate(T* dst, T* src, int n)
+  {
+    memcpy(dst, src, n * sizeof(T));
+  }
+
+  static void shiftUp(T* p, int n)
+  {
+    memmove(p + 1, p, n * sizeof(T));
+  }
+
+  static void shiftDown(T* p, int n)
+  {
+    memmove(p, p + 1, n * sizeof(T));
+  }
+
+  static void destroy(T*, int)
+  {
+    // do nothing
+  }
+
+}; // ArrayElements
 
 
 //////////////////////////////////////////////////////////
 //
 // Array: generic array class
 // =====
+//
+// The capacity grows geometrically (at least doubles, or grows by
+// delta if it is greater), so that adding n elements costs O(n).
 template <typename T>
 class Array
 {
 public:
-  // Constructor
+  // Constructors
   Array(int = DFL_ARRAY_SIZE, int = 0);
+  Array(Array<T>&&);
 
   // Destructor
   ~Array()
   {
-    delete []data;
+    clear();
+    ::operator delete(data);
   }
 
+  Array<T>& operator =(Array<T>&&);
+
   void add(const T&);
+  void add(T&&);
   void addAt(const T&, int);
   bool removeAt(int);
 
@@ -62,6 +154,15 @@ public:
     return i >= 0 ? removeAt(i) : false;
   }
 
+  void clear()
+  {
+    ArrayElements<T>::destroy(data, numberOfElements);
+    numberOfElements = 0;
+  }
+
+  // Make room for (at least) a number of elements
+  void reserve(int);
+
   T& operator [](int i)
   {
     PRECONDITION(i >= 0 && i < numberOfElements);
@@ -74,6 +175,16 @@ public:
     return this->data[i];
   }
 
+  T* getData()
+  {
+    return data;
+  }
+
+  const T* getData() const
+  {
+    return data;
+  }
+
   int findIndex(const T&) const;
 
   int size() const
@@ -81,6 +192,11 @@ public:
     return numberOfElements;
   }
 
+  int getCapacity() const
+  {
+    return capacity;
+  }
+
   bool isEmpty() const
   {
     return numberOfElements == 0;
@@ -110,46 +226,107 @@ private:
 template <typename T>
 Array<T>::Array(int initSize, int delta)
 {
-  PRECONDITION(initSize > 0 && delta >= 0);
-  data = new T[capacity = initSize];
+  PRECONDITION(initSize >= 0 && delta >= 0);
+  capacity = initSize;
+  data = (T*)::operator new(capacity * sizeof(T));
   this->delta = delta > 0 ? delta : DFL_ARRAY_SIZE;
   numberOfElements = 0;
 }
 
+template <typename T>
+Array<T>::Array(Array<T>&& array):
+  capacity(array.capacity),
+  delta(array.delta),
+  numberOfElements(array.numberOfElements),
+  data(array.data)
+{
+  array.capacity = array.numberOfElements = 0;
+  array.data = 0;
+}
+
+template <typename T>
+Array<T>&
+Array<T>::operator =(Array<T>&& array)
+{
+  if (this != &array)
+  {
+    clear();
+    ::operator delete(data);
+    capacity = array.capacity;
+    delta = array.delta;
+    numberOfElements = array.numberOfElements;
+    data = array.data;
+    array.capacity = array.numberOfElements = 0;
+    array.data = 0;
+  }
+  return *this;
+}
+
 template <typename T>
 void
-Array<T>::resize()
+Array<T>::reserve(int n)
 {
-  int newSize = this->capacity + delta;
-  T* temp = new T[newSize];
+  if (n <= capacity)
+    return;
 
-  memcpy(temp, this->data, this->capacity * sizeof(T));
-  delete []this->data;
-  this->capacity = newSize;
+  T* temp = (T*)::operator new(n * sizeof(T));
+
+  ArrayElements<T>::relocate(temp, this->data, numberOfElements);
+  ::operator delete(this->data);
+  this->capacity = n;
   this->data = temp;
 }
 
+template <typename T>
+void
+Array<T>::resize()
+{
+  reserve(capacity + (capacity > delta ? capacity : delta));
+}
+
 template <typename T>
 void
 Array<T>::add(const T& t)
 {
   if (numberOfElements >= this->capacity)
+  {
+    // t can be an element of this array
+    T temp(t);
+
     resize();
-  this->data[numberOfElements++] = t;
+    new (this->data + numberOfElements++) T(std::move(temp));
+  }
+  else
+    new (this->data + numberOfElements++) T(t);
 }
 
 template <typename T>
 void
-Array<T>::addAt(const T& t, int i)
+Array<T>::add(T&& t)
 {
-  PRECONDITION(i >= 0 && i < numberOfElements);
   if (numberOfElements >= this->capacity)
+  {
+    T temp(std::move(t));
+
     resize();
+    new (this->data + numberOfElements++) T(std::move(temp));
+  }
+  else
+    new (this->data + numberOfElements++) T(std::move(t));
+}
 
-  T* src = this->data + i;
+template <typename T>
+void
+Array<T>::addAt(const T& t, int i)
+{
+  PRECONDITION(i >= 0 && i < numberOfElements);
 
-  memmove(src + 1, src, (numberOfElements - i) * sizeof(T));
-  this->data[i] = t;
+  T temp(t);
+
+  if (numberOfElements >= this->capacity)
+    resize();
+  ArrayElements<T>::shiftUp(this->data + i, numberOfElements - i);
+  new (this->data + i) T(std::move(temp));
   numberOfElements++;
 }
 
@@ -164,7 +341,8 @@ Array<T>::removeAt(int i)
 
   T* dst = this->data + i;
 
-  memmove(dst, dst + 1, (numberOfElements - i) * sizeof(T));
+  dst->~T();
+  ArrayElements<T>::shiftDown(dst, numberOfElements - i);
   return true;
 }
 
@@ -244,6 +422,8 @@ protected:
 //
 // PointerArray: generic pointer array class
 // ============
+//
+// The capacity grows geometrically, as in Array.
 template <typename T>
 class PointerArray
 {
@@ -273,6 +453,9 @@ public:
 
   void clear(bool = false);
 
+  // Make room for (at least) a number of pointers
+  void reserve(int);
+
   T*& operator [](int i)
   {
     PRECONDITION(i >= 0 && i < numberOfElements);
@@ -330,17 +513,27 @@ PointerArray<T>::PointerArray(int initSize, int delta):
 
 template <typename T>
 void
-PointerArray<T>::resize()
+PointerArray<T>::reserve(int n)
 {
-  int newSize = this->capacity + delta;
-  T** temp = new T*[newSize];
+  if (n <= capacity)
+    return;
 
-  memcpy(temp, this->data, this->capacity * sizeof(T*));
+  T** temp = new T*[n];
+
+  memcpy(temp, this->data, numberOfElements * sizeof(T*));
   delete []this->data;
-  this->capacity = newSize;
+  this->capacity = n;
   this->data = temp;
 }
 
+template <typename T>
+void
+PointerArray<T>::resize()
+{
+  // Geometric growth, as in Array
+  reserve(capacity + (capacity > delta ? capacity : delta));
+}
+
 template <typename T>
 void
 PointerArray<T>::add(T* t)
@@ -468,6 +661,201 @@ protected:
 
 }; // PointerArrayIterator
 
+
+//////////////////////////////////////////////////////////
+//
+// SmallArray: generic small-buffer array class
+// ==========
+//
+// The first N elements are stored in a buffer inside the array
+// itself; only larger arrays allocate their storage, which grows
+// geometrically. The elements are always contiguous.
+template <typename T, int N>
+class SmallArray
+{
+public:
+  // Constructor
+  SmallArray():
+    capacity(N),
+    numberOfElements(0)
+  {
+    data = (T*)&buffer;
+  }
+
+  // Destructor
+  ~SmallArray()
+  {
+    clear();
+    if (!isSmall())
+      ::operator delete(data);
+  }
+
+  void add(const T&);
+
+  void clear()
+  {
+    ArrayElements<T>::destroy(data, numberOfElements);
+    numberOfElements = 0;
+  }
+
+  // Make room for (at least) a number of elements
+  void reserve(int);
+
+  T& operator [](int i)
+  {
+    PRECONDITION(i >= 0 && i < numberOfElements);
+    return data[i];
+  }
+
+  const T& operator [](int i) const
+  {
+    PRECONDITION(i >= 0 && i < numberOfElements);
+    return data[i];
+  }
+
+  T* getData()
+  {
+    return data;
+  }
+
+  const T* getData() const
+  {
+    return data;
+  }
+
+  int size() const
+  {
+    return numberOfElements;
+  }
+
+  int getCapacity() const
+  {
+    return capacity;
+  }
+
+  bool isEmpty() const
+  {
+    return numberOfElements == 0;
+  }
+
+  bool isSmall() const
+  {
+    return data == (const T*)&buffer;
+  }
+
+protected:
+  int capacity;
+  int numberOfElements;
+  T* data;
+  typename std::aligned_storage<N * sizeof(T),
+    std::alignment_of<T>::value>::type buffer;
+
+private:
+  SmallArray(const SmallArray<T, N>&);
+  SmallArray<T, N>& operator =(const SmallArray<T, N>&);
+
+  friend class SmallArrayIterator<T, N>;
+
+}; // SmallArray
+
+
+//////////////////////////////////////////////////////////
+//
+// SmallArray implementation
+// ==========
+template <typename T, int N>
+void
+SmallArray<T, N>::reserve(int n)
+{
+  if (n <= capacity)
+    return;
+
+  T* temp = (T*)::operator new(n * sizeof(T));
+
+  ArrayElements<T>::relocate(temp, data, numberOfElements);
+  if (!isSmall())
+    ::operator delete(data);
+  capacity = n;
+  data = temp;
+}
+
+template <typename T, int N>
+void
+SmallArray<T, N>::add(const T& t)
+{
+  if (numberOfElements >= capacity)
+  {
+    // t can be an element of this array
+    T temp(t);
+
+    reserve(2 * capacity);
+    new (data + numberOfElements++) T(std::move(temp));
+  }
+  else
+    new (data + numberOfElements++) T(t);
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// SmallArrayIterator: generic small-buffer array iterator class
+// ==================
+template <typename T, int N>
+class SmallArrayIterator
+{
+public:
+  // Constructor
+  SmallArrayIterator(const SmallArray<T, N>& array)
+  {
+    this->array = &array;
+    cur = 0;
+  }
+
+  // Testing if objects remain in the iterator
+  operator int() const
+  {
+    return cur < array->numberOfElements;
+  }
+
+  // Get the current object
+  T& current() const
+  {
+    return array->data[cur];
+  }
+
+  // Restart the iterator
+  void restart()
+  {
+    cur = 0;
+  }
+
+  // Next/previous object
+  T& operator ++(int)
+  {
+    return array->data[cur++];
+  }
+
+  T& operator ++()
+  {
+    return array->data[++cur];
+  }
+
+  T& operator --(int)
+  {
+    return array->data[cur--];
+  }
+
+  T& operator --()
+  {
+    return array->data[--cur];
+  }
+
+protected:
+  const SmallArray<T, N>* array;
+  int cur;
+
+}; // SmallArrayIterator
+
 } // end namespace Collections
 
 } // end namespace System
@@ -15,12 +15,14 @@
 //  ========
 //  Class definition for camera.
 
+#include "Geometry/Bounds3.h"
 #include "Math/Matrix4x4.h"
 #include "NameableObject.h"
 
 typedef unsigned int uint;
 
 using namespace Ds;
+using namespace Geometry;
 using namespace System;
 
 namespace Graphics
@@ -71,6 +73,7 @@ public:
   REAL getAspectRatio() const;
   void getClippingPlanes(REAL&, REAL&) const;
   REAL windowHeight() const;
+  REAL projectedSize(const Bounds3&) const;
 
   void setPosition(const vec3&);
   void setDirectionOfProjection(const vec3&);
@@ -101,6 +104,7 @@ public:
   mat4 getWorldToCameraMatrix() const;
   mat4 getCameraToWorldMatrix() const;
   mat4 getProjectionMatrix() const;
+  mat4 getViewProjectionMatrix() const;
 
   vec3 worldToCamera(const vec3&) const;
   vec3 cameraToWorld(const vec3&) const;
@@ -126,6 +130,7 @@ protected:
   mat4 matrix; // view matrix
   mat4 inverseMatrix;
   mat4 projectionMatrix;
+  mat4 vpMatrix; // projection * view
 
   static string defaultName();
 
@@ -248,6 +253,12 @@ Camera::getProjectionMatrix() const
   return projectionMatrix;
 }
 
+inline mat4
+Camera::getViewProjectionMatrix() const
+{
+  return vpMatrix;
+}
+
 inline vec3
 Camera::worldToCamera(const vec3& p) const
 {
@@ -0,0 +1,160 @@
+#ifndef __ChunkedMesh_h
+#define __ChunkedMesh_h
+
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: ChunkedMesh.h
+//  ========
+//  Class definition for out-of-core chunked triangle mesh.
+
+#include "Array.h"
+#include "List.h"
+#include "TriangleMesh.h"
+
+using namespace System::Collections;
+
+namespace Graphics
+{ // begin namespace Graphics
+
+#define DFL_CHUNK_SIZE       4096      // triangles per chunk
+#define DFL_CHUNK_CACHE_SIZE 0x4000000 // bytes (64 MB)
+
+
+//////////////////////////////////////////////////////////
+//
+// ChunkedMesh: out-of-core chunked triangle mesh class
+// ===========
+//
+// A chunked mesh file stores the triangles of a mesh grouped into
+// spatial clusters (chunks). Each chunk is a self-contained triangle
+// mesh with its own (local) vertices, normals and colors, and can be
+// paged in on demand by its ID. Chunks paged in are kept in a LRU
+// cache whose size (in bytes) is fixed when the file is opened.
+//
+class ChunkedMesh: public Object
+{
+public:
+  struct Chunk
+  {
+    Bounds3 bounds;
+    int64 offset;
+    int numberOfVertices;
+    int numberOfTriangles;
+    int64 size;
+
+  }; // Chunk
+
+  struct Statistics
+  {
+    int hits;
+    int misses;
+    int evictions;
+
+  }; // Statistics
+
+  // Write a chunked mesh file
+  static bool write(const char*, const TriangleMesh&, int = DFL_CHUNK_SIZE);
+
+  // Open a chunked mesh file
+  static ChunkedMesh* open(const char*, int64 = DFL_CHUNK_CACHE_SIZE);
+
+  // Destructor
+  ~ChunkedMesh();
+
+  int getNumberOfChunks() const
+  {
+    return numberOfChunks;
+  }
+
+  const Chunk& getChunkInfo(int id) const
+  {
+    PRECONDITION(id >= 0 && id < numberOfChunks);
+    return chunks[id];
+  }
+
+  const Bounds3& chunkBounds(int id) const
+  {
+    return getChunkInfo(id).bounds;
+  }
+
+  const Bounds3& boundingBox() const
+  {
+    return bounds;
+  }
+
+  // Get (and page in, if necessary) the chunk id
+  TriangleMesh* getChunk(int id);
+
+  bool isResident(int id) const
+  {
+    PRECONDITION(id >= 0 && id < numberOfChunks);
+    return entries[id] != 0;
+  }
+
+  int64 getCacheSize() const
+  {
+    return cacheSize;
+  }
+
+  int64 getCacheUsage() const
+  {
+    return cacheUsage;
+  }
+
+  void setCacheSize(int64);
+  void flush();
+
+  const Statistics& getStatistics() const
+  {
+    return stats;
+  }
+
+private:
+  class CacheEntry
+  {
+  public:
+    ObjectPtr<TriangleMesh> mesh;
+    int id;
+
+    // Constructor
+    CacheEntry(TriangleMesh* m, int i):
+      mesh(m),
+      id(i)
+    {
+      // do nothing
+    }
+
+    DECLARE_LIST_ELEMENT(CacheEntry);
+
+  }; // CacheEntry
+
+  FILE* file;
+  int flags;
+  int numberOfChunks;
+  Chunk* chunks;
+  Bounds3 bounds;
+  CacheEntry** entries;
+  ListImp<CacheEntry> lru; // head is the most recently used
+  int64 cacheSize;
+  int64 cacheUsage;
+  Statistics stats;
+
+  // Private constructor
+  ChunkedMesh(FILE*, int64);
+
+  TriangleMesh* readChunk(int);
+  void evict(int);
+
+}; // ChunkedMesh
+
+} // end namespace Graphics
+
+#endif // __ChunkedMesh_h
@@ -0,0 +1,51 @@
+#ifndef __ChunkedMeshShape_h
+#define __ChunkedMeshShape_h
+
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: ChunkedMeshShape.h
+//  ========
+//  Class definition for chunked triangle mesh shape.
+
+#include "ChunkedMesh.h"
+#include "Model.h"
+
+namespace Graphics
+{ // begin namespace Graphics
+
+
+//////////////////////////////////////////////////////////
+//
+// ChunkedMeshShape: chunked triangle mesh shape class
+// ================
+class ChunkedMeshShape: public Primitive
+{
+public:
+  // Constructor
+  ChunkedMeshShape(ChunkedMesh* aMesh):
+    mesh(aMesh)
+  {
+    // do nothing
+  }
+
+  Object* clone() const;
+  Bounds3 boundingBox() const;
+  const TriangleMesh* triangleMesh() const;
+  ChunkedMesh* chunkedMesh() const;
+
+private:
+  ObjectPtr<ChunkedMesh> mesh;
+
+}; // ChunkedMeshShape
+
+} // end namespace Graphics
+
+#endif // __ChunkedMeshShape_h
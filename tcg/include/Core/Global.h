@@ -56,8 +56,8 @@ typedef signed int int32;
 typedef unsigned int uint32;
 typedef signed int int32;
 typedef unsigned int uint32;
-typedef signed long int int64;
-typedef unsigned long int uint64;
+typedef signed long long int64;
+typedef unsigned long long uint64;
 typedef unsigned char uchar;
 typedef unsigned short ushort;
 typedef unsigned int uint;
@@ -96,6 +96,7 @@ public:
   static void setUniform(GLint, float, float, float, float);
   static void setUniform(GLint, const vec3f&);
   static void setUniform(GLint, const vec4f&);
+  static void setUniform(GLint, const mat3f&);
   static void setUniform(GLint, const mat4f&);
   static void setUniform(GLint, const Color&);
 
@@ -105,6 +106,7 @@ public:
   void setUniform(const char*, float, float, float, float);
   void setUniform(const char*, const vec3f&);
   void setUniform(const char*, const vec4f&);
+  void setUniform(const char*, const mat3f&);
   void setUniform(const char*, const mat4f&);
   void setUniform(const char*, const Color&);
 
@@ -168,6 +170,12 @@ Program::setUniform(GLint loc, const vec4f& v)
   glUniform4fv(loc, 1, &v[0]);
 }
 
+inline void
+Program::setUniform(GLint loc, const mat3f& v)
+{
+  glUniformMatrix3fv(loc, 1, GL_FALSE, v.data());
+}
+
 inline void
 Program::setUniform(GLint loc, const mat4f& v)
 {
@@ -216,6 +224,12 @@ Program::setUniform(const char* name, const vec4f& v)
   setUniform(getUniformLocation(name), v);
 }
 
+inline void
+Program::setUniform(const char* name, const mat3f& v)
+{
+  setUniform(getUniformLocation(name), v);
+}
+
 inline void
 Program::setUniform(const char* name, const mat4f& v)
 {
@@ -15,7 +15,9 @@
 //  ========
 //  Class definition for GL renderer.
 
+#include "ChunkedMeshShape.h"
 #include "GLProgram.h"
+#include "OcclusionCuller.h"
 #include "Renderer.h"
 #include "TriangleMeshShape.h"
 
@@ -34,6 +36,7 @@ public:
   GLVertexArray(const TriangleMesh*);
 
   void render();
+  void render(int, int);
 
   // Destructor
   ~GLVertexArray();
@@ -66,11 +69,15 @@ public:
   {
     UseLights = 1,
     DrawSceneBounds = 2,
-    UseVertexColors = 4
+    UseVertexColors = 4,
+    CullMeshlets = 8,
+    CullActors = 16,
+    CullOccluded = 32
   };
 
   RenderMode renderMode;
   Flags flags;
+  REAL lodThreshold; // max LOD error in pixels
 
   // Constructor
   GLRenderer(Scene&, Camera* = 0);
@@ -78,6 +85,25 @@ public:
   void update();
   void render();
 
+  // Number of visible actors outside the view frustum in the
+  // last frame
+  int getNumberOfCulledActors() const
+  {
+    return culledActors;
+  }
+
+  // Number of actors in the view frustum hidden by the occluders
+  // in the last frame
+  int getNumberOfOccludedActors() const
+  {
+    return occludedActors;
+  }
+
+  OcclusionCuller& getOcclusionCuller()
+  {
+    return occlusionCuller;
+  }
+
 protected:
   virtual void startRender();
   virtual void endRender();
@@ -87,17 +113,27 @@ protected:
   virtual void drawLine(const vec3&, const vec3&) const;
   virtual void drawAABB(const Bounds3&) const;
 
-  // TODO
-  void drawMesh(const Model*) const;
+  void drawGeometry(const Model*, TriangleMesh*, const mat4&) const;
+  void drawActor(const ActorTable&, int);
+  void drawMeshlets(const mat4&, TriangleMesh*) const;
+  void cullActors(const ActorTable&);
+  void cullOccludedActors(const ActorTable&);
+  const TriangleMesh* rowMesh(const ActorTable&, int, REAL);
 
 private:
   mat4 vpMatrix;
   GLSL::Program program;
   GLint vpMatrixLoc;
   GLint modelMatrixLoc;
+  GLint normalMatrixLoc;
   GLint ambientLightLoc;
   GLint OaLoc;
   GLint OdLoc;
+  Frustum frustum;
+  Array<int> visibleRows; // rows drawn in the current frame
+  int culledActors;
+  OcclusionCuller occlusionCuller;
+  int occludedActors;
 
 }; // GLRenderer
 
@@ -0,0 +1,463 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: AABBTree.h
+// ========
+// Class definition for dynamic AABB tree.
+
+#ifndef __AABBTree_h
+#define __AABBTree_h
+
+#include "Geometry/Frustum.h"
+
+DS_BEGIN_NAMESPACE
+
+namespace Geometry
+{ // begin namespace Geometry
+
+#define DFL_AABB_TREE_SIZE 16
+#define DFL_AABB_TREE_MARGIN 0.1
+// The tree is balanced, so its height is O(log n)
+#define MAX_AABB_TREE_STACK 256
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// AABBTree: dynamic AABB tree class
+// ========
+//
+// A binary tree of boxes whose leaves (proxies) are boxes given
+// by the user, each one with an integer, and whose inner nodes
+// are the unions of their children. The box of a leaf is the user
+// box enlarged by a margin (relative to its size), so that a box
+// moving within its enlarged box does not change the tree. Leaves
+// are inserted where the increase of the node surface areas is
+// minimal, and the tree is rebalanced by rotations on the way up.
+//
+// The queries report the integers of the leaves whose (enlarged)
+// boxes pass a test to a function object f, until f returns false.
+class AABBTree
+{
+public:
+  /// Constructs an empty AABBTree object.
+  explicit AABBTree(REAL margin = REAL(DFL_AABB_TREE_MARGIN)):
+    nodes(0),
+    capacity(0),
+    root(-1),
+    freeList(-1),
+    margin(margin)
+  {
+    // do nothing
+  }
+
+  /// Destructor.
+  ~AABBTree()
+  {
+    delete []nodes;
+  }
+
+  /// \brief Inserts a leaf with the box b and the integer data, and
+  /// returns the leaf.
+  int insert(const Bounds3& b, int data)
+  {
+    int leaf = newNode();
+
+    nodes[leaf].box = enlarge(b);
+    nodes[leaf].data = data;
+    insertLeaf(leaf);
+    return leaf;
+  }
+
+  /// Removes the leaf.
+  void remove(int leaf)
+  {
+    removeLeaf(leaf);
+    freeNode(leaf);
+  }
+
+  /// \brief Sets the box of the leaf to b. Returns true if the leaf
+  /// was reinserted, i.e., its enlarged box did not contain b or
+  /// was too large.
+  bool move(int leaf, const Bounds3& b)
+  {
+    const Bounds3& box = nodes[leaf].box;
+    Bounds3 e = enlarge(b);
+
+    if (box.contains(b) && box.area() <= 4 * e.area())
+      return false;
+    removeLeaf(leaf);
+    nodes[leaf].box = e;
+    insertLeaf(leaf);
+    return true;
+  }
+
+  /// Returns the integer of the leaf.
+  int getData(int leaf) const
+  {
+    return nodes[leaf].data;
+  }
+
+  /// Sets the integer of the leaf.
+  void setData(int leaf, int data)
+  {
+    nodes[leaf].data = data;
+  }
+
+  /// Returns the (enlarged) box of the leaf.
+  const Bounds3& getBox(int leaf) const
+  {
+    return nodes[leaf].box;
+  }
+
+  /// Returns the height of this object (-1 if it is empty).
+  int height() const
+  {
+    return root < 0 ? -1 : nodes[root].height;
+  }
+
+  /// Removes all leaves of this object.
+  void clear()
+  {
+    delete []nodes;
+    nodes = 0;
+    capacity = 0;
+    root = freeList = -1;
+  }
+
+  /// Reports the leaves whose boxes overlap the box b.
+  template <typename F>
+  void query(const Bounds3& b, F f) const
+  {
+    traverse([&](const Bounds3& box) { return box.intersect(b); }, f);
+  }
+
+  /// Reports the leaves whose boxes are not outside the frustum.
+  template <typename F>
+  void query(const Frustum& frustum, F f) const
+  {
+    traverse([&](const Bounds3& box) { return !frustum.isOutside(box); }, f);
+  }
+
+  /// Reports the leaves whose boxes overlap the sphere (c, r).
+  template <typename F>
+  void query(const vec3& c, REAL r, F f) const
+  {
+    const REAL r2 = r * r;
+
+    traverse([&](const Bounds3& box) { return box.squaredDistance(c) <= r2; },
+      f);
+  }
+
+  /// Reports the leaves whose boxes are hit by the ray.
+  template <typename F>
+  void query(const Ray& ray, F f) const
+  {
+    REAL t;
+
+    traverse([&](const Bounds3& box) { return box.intersect(ray, t); }, f);
+  }
+
+private:
+  struct Node
+  {
+    Bounds3 box;
+    int parent; // or the next free node
+    int children[2]; // -1 in leaves
+    int height; // 0 in leaves
+    int data;
+
+    bool isLeaf() const
+    {
+      return children[0] < 0;
+    }
+
+  }; // Node
+
+  Node* nodes;
+  int capacity;
+  int root;
+  int freeList;
+  REAL margin;
+
+  AABBTree(const AABBTree&);
+  AABBTree& operator =(const AABBTree&);
+
+  static Bounds3 merge(const Bounds3& a, const Bounds3& b)
+  {
+    Bounds3 u = a;
+
+    u.inflate(b);
+    return u;
+  }
+
+  Bounds3 enlarge(const Bounds3& b) const
+  {
+    const vec3& p1 = b.getMin();
+    const vec3& p2 = b.getMax();
+
+    // Empty boxes are not enlarged
+    if (p1.x > p2.x || p1.y > p2.y || p1.z > p2.z)
+      return b;
+
+    const vec3 d = (p2 - p1) * margin;
+
+    return Bounds3(p1 - d, p2 + d);
+  }
+
+  int newNode()
+  {
+    if (freeList < 0)
+    {
+      const int n = capacity > 0 ? 2 * capacity : DFL_AABB_TREE_SIZE;
+      Node* temp = new Node[n];
+
+      for (int i = 0; i < capacity; i++)
+        temp[i] = nodes[i];
+      delete []nodes;
+      nodes = temp;
+      for (int i = capacity; i < n; i++)
+        nodes[i].parent = i + 1 < n ? i + 1 : -1;
+      freeList = capacity;
+      capacity = n;
+    }
+
+    const int i = freeList;
+    Node& node = nodes[i];
+
+    freeList = node.parent;
+    node.parent = node.children[0] = node.children[1] = -1;
+    node.height = 0;
+    node.data = -1;
+    return i;
+  }
+
+  void freeNode(int i)
+  {
+    nodes[i].parent = freeList;
+    nodes[i].height = -1;
+    freeList = i;
+  }
+
+  // Cost of descending into the child c when inserting the box b
+  REAL descendingCost(int c, const Bounds3& b) const
+  {
+    const REAL area = merge(nodes[c].box, b).area();
+
+    return nodes[c].isLeaf() ? area : area - nodes[c].box.area();
+  }
+
+  void insertLeaf(int leaf)
+  {
+    if (root < 0)
+    {
+      root = leaf;
+      nodes[root].parent = -1;
+      return;
+    }
+
+    // Find the best sibling for the leaf
+    const Bounds3 b = nodes[leaf].box;
+    int sibling = root;
+
+    while (!nodes[sibling].isLeaf())
+    {
+      const Node& node = nodes[sibling];
+      const REAL area = node.box.area();
+      const REAL combinedArea = merge(node.box, b).area();
+      // Cost of a new parent for this node and the leaf, and the
+      // minimum cost of pushing the leaf further down the tree
+      const REAL cost = 2 * combinedArea;
+      const REAL inheritance = 2 * (combinedArea - area);
+      const REAL cost0 = descendingCost(node.children[0], b) + inheritance;
+      const REAL cost1 = descendingCost(node.children[1], b) + inheritance;
+
+      if (cost < cost0 && cost < cost1)
+        break;
+      sibling = node.children[cost0 < cost1 ? 0 : 1];
+    }
+
+    // newNode() can move the nodes
+    const int parent = newNode();
+    const int oldParent = nodes[sibling].parent;
+
+    nodes[parent].parent = oldParent;
+    nodes[parent].box = merge(b, nodes[sibling].box);
+    nodes[parent].height = nodes[sibling].height + 1;
+    nodes[parent].children[0] = sibling;
+    nodes[parent].children[1] = leaf;
+    nodes[sibling].parent = nodes[leaf].parent = parent;
+    if (oldParent < 0)
+      root = parent;
+    else
+      replaceChild(oldParent, sibling, parent);
+    refit(parent);
+  }
+
+  void removeLeaf(int leaf)
+  {
+    if (leaf == root)
+    {
+      root = -1;
+      return;
+    }
+
+    const int parent = nodes[leaf].parent;
+    const int grandParent = nodes[parent].parent;
+    const int sibling = nodes[parent].children[0] == leaf ?
+      nodes[parent].children[1] :
+      nodes[parent].children[0];
+
+    // The sibling replaces the parent
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+    if (grandParent < 0)
+      root = sibling;
+    else
+    {
+      replaceChild(grandParent, parent, sibling);
+      refit(grandParent);
+    }
+  }
+
+  void replaceChild(int parent, int child, int newChild)
+  {
+    Node& node = nodes[parent];
+
+    node.children[node.children[0] == child ? 0 : 1] = newChild;
+  }
+
+  // Fix the boxes and heights of the node i and its ancestors
+  void refit(int i)
+  {
+    while (i >= 0)
+    {
+      i = balance(i);
+
+      Node& node = nodes[i];
+      const Node& c0 = nodes[node.children[0]];
+      const Node& c1 = nodes[node.children[1]];
+
+      node.height = 1 + (c0.height > c1.height ? c0.height : c1.height);
+      node.box = merge(c0.box, c1.box);
+      i = node.parent;
+    }
+  }
+
+  // Promote the taller child of the node i if the heights of its
+  // children differ by more than one; return the root of the subtree
+  int balance(int i)
+  {
+    const Node& node = nodes[i];
+
+    if (node.isLeaf() || node.height < 2)
+      return i;
+
+    const int d = nodes[node.children[1]].height -
+      nodes[node.children[0]].height;
+
+    if (d > 1)
+      return rotate(i, 1);
+    if (d < -1)
+      return rotate(i, 0);
+    return i;
+  }
+
+  // Promote the k-th child x of the node a to the place of a
+  int rotate(int a, int k)
+  {
+    Node& A = nodes[a];
+    const int x = A.children[k];
+    const int y = A.children[1 - k];
+    Node& X = nodes[x];
+    int f = X.children[0];
+    int g = X.children[1];
+
+    X.children[0] = a;
+    X.parent = A.parent;
+    A.parent = x;
+    if (X.parent < 0)
+      root = x;
+    else
+      replaceChild(X.parent, a, x);
+    // The taller child g of x stays with x and the other one takes
+    // the place of x in a
+    if (nodes[f].height > nodes[g].height)
+    {
+      const int t = f;
+
+      f = g;
+      g = t;
+    }
+    X.children[1] = g;
+    A.children[k] = f;
+    nodes[f].parent = a;
+
+    const Node& Y = nodes[y];
+    const Node& F = nodes[f];
+    const Node& G = nodes[g];
+
+    A.box = merge(Y.box, F.box);
+    A.height = 1 + (Y.height > F.height ? Y.height : F.height);
+    X.box = merge(A.box, G.box);
+    X.height = 1 + (A.height > G.height ? A.height : G.height);
+    return x;
+  }
+
+  template <typename Test, typename F>
+  void traverse(Test test, F f) const
+  {
+    if (root < 0)
+      return;
+
+    int stack[MAX_AABB_TREE_STACK];
+    int top = 0;
+
+    stack[top++] = root;
+    while (top > 0)
+    {
+      const Node& node = nodes[stack[--top]];
+
+      if (!test(node.box))
+        continue;
+      if (node.isLeaf())
+      {
+        if (!f(node.data))
+          return;
+      }
+      else
+      {
+        stack[top++] = node.children[0];
+        stack[top++] = node.children[1];
+      }
+    }
+  }
+
+}; // AABBTree
+
+} // end namespace Geometry
+
+DS_END_NAMESPACE
+
+#endif // __AABBTree_h
@@ -33,15 +33,16 @@
 #ifndef __Bounds3_h
 #define __Bounds3_h
 
-#include "Math/Matrix4x4.h"
+#include "Geometry/Ray.h"
 
 DS_BEGIN_NAMESPACE
 
 namespace Geometry
 { // begin namespace Geometry
 
+template <typename real>
 __host__ __device__ inline void
-inflateBounds3(vec3& p1, vec3& p2, const vec3& p)
+inflateBounds3(Vector3<real>& p1, Vector3<real>& p2, const Vector3<real>& p)
 {
   if (p.x < p1.x)
     p1.x = p.x;
@@ -60,30 +61,45 @@ inflateBounds3(vec3& p1, vec3& p2, const vec3& p)
 
 /////////////////////////////////////////////////////////////////////
 //
-// Bounds3: axis-aligned bounding box class
-// =======
-class Bounds3
+// BoundingBox3: axis-aligned bounding box class
+// ============
+template <typename real>
+class BoundingBox3
 {
 public:
-  /// Constructs an empty Bounds3 object.
+  typedef Vector3<real> vec3;
+  typedef Matrix4x4<real> mat4;
+  typedef BoundingBox3<real> Bounds3;
+  typedef Ray3<real> Ray;
+
+  /// Constructs an empty BoundingBox3 object.
   __host__ __device__
-  Bounds3()
+  BoundingBox3()
   {
     setEmpty();
   }
 
-  Bounds3(const vec3& min, const vec3& max)
+  BoundingBox3(const vec3& min, const vec3& max)
   {
     set(min, max);
   }
 
-  Bounds3(const Bounds3& b, const mat4& m = mat4::identity()):
+  BoundingBox3(const Bounds3& b, const mat4& m = mat4::identity()):
     p1(b.p1),
     p2(b.p2)
   {
     transform(m);
   }
 
+  /// Constructs a BoundingBox3 object from b of another precision.
+  template <typename T>
+  explicit BoundingBox3(const BoundingBox3<T>& b):
+    p1(b.getMin()),
+    p2(b.getMax())
+  {
+    // do nothing
+  }
+
   __host__ __device__
   vec3 center() const
   {
@@ -91,7 +107,7 @@ public:
   }
 
   __host__ __device__
-  REAL diagonalLength() const
+  real diagonalLength() const
   {
     return (p2 - p1).length();
   }
@@ -103,16 +119,16 @@ public:
   }
 
   __host__ __device__
-  REAL maxSize() const
+  real maxSize() const
   {
     return size().max();
   }
 
   __host__ __device__
-  REAL area() const
+  real area() const
   {
     vec3 s = size();
-    REAL a = s.x * s.y + s.y * s.z + s.z * s.x;
+    real a = s.x * s.y + s.y * s.z + s.z * s.x;
 
     return a + a;
   }
@@ -138,8 +154,8 @@ public:
   __host__ __device__
   void setEmpty()
   {
-    p1.x = p1.y = p1.z = +FloatInfo<REAL>::inf();
-    p2.x = p2.y = p2.z = -FloatInfo<REAL>::inf();
+    p1.x = p1.y = p1.z = +FloatInfo<real>::inf();
+    p2.x = p2.y = p2.z = -FloatInfo<real>::inf();
   }
 
   __host__ __device__
@@ -148,29 +164,29 @@ public:
     p1 = min;
     p2 = max;
     if (max.x < min.x)
-      dSwap<REAL>(p1.x, p2.x);
+      dSwap<real>(p1.x, p2.x);
     if (max.y < min.y)
-      dSwap<REAL>(p1.y, p2.y);
+      dSwap<real>(p1.y, p2.y);
     if (max.z < min.z)
-      dSwap<REAL>(p1.z, p2.z);
+      dSwap<real>(p1.z, p2.z);
   }
 
   __host__ __device__
   void inflate(const vec3& p)
   {
-    inflateBounds3(p1, p2, p);
+    inflateBounds3<real>(p1, p2, p);
   }
 
   __host__ __device__
-  void inflate(REAL x, REAL y, REAL z = 0)
+  void inflate(real x, real y, real z = 0)
   {
     inflate(vec3(x, y, z));
   }
 
   __host__ __device__
-  void inflate(REAL s)
+  void inflate(real s)
   {
-    if (Math::isPositive<REAL>(s))
+    if (Math::isPositive<real>(s))
     {
       vec3 c = center() * (1 - s);
 
@@ -179,11 +195,23 @@ public:
     }
   }
 
+  /// \brief Inflates this object to contain the box b. The corners
+  /// are merged component-wise, so that an empty b does nothing.
   __host__ __device__
   void inflate(const Bounds3& b)
   {
-    inflate(b.p1);
-    inflate(b.p2);
+    if (b.p1.x < p1.x)
+      p1.x = b.p1.x;
+    if (b.p2.x > p2.x)
+      p2.x = b.p2.x;
+    if (b.p1.y < p1.y)
+      p1.y = b.p1.y;
+    if (b.p2.y > p2.y)
+      p2.y = b.p2.y;
+    if (b.p1.z < p1.z)
+      p1.z = b.p1.z;
+    if (b.p2.z > p2.z)
+      p2.z = b.p2.z;
   }
 
   __host__ __device__
@@ -219,11 +247,73 @@ public:
     return true;
   }
 
+  /// Returns true if this object contains the box b.
+  __host__ __device__
+  bool contains(const Bounds3& b) const
+  {
+    return p1.x <= b.p1.x && p1.y <= b.p1.y && p1.z <= b.p1.z &&
+      p2.x >= b.p2.x && p2.y >= b.p2.y && p2.z >= b.p2.z;
+  }
+
+  /// Returns true if this object and the box b overlap.
+  __host__ __device__
+  bool intersect(const Bounds3& b) const
+  {
+    return p1.x <= b.p2.x && p1.y <= b.p2.y && p1.z <= b.p2.z &&
+      p2.x >= b.p1.x && p2.y >= b.p1.y && p2.z >= b.p1.z;
+  }
+
+  /// \brief Returns the squared distance from p to this object (0 if
+  /// this object contains p).
+  __host__ __device__
+  real squaredDistance(const vec3& p) const
+  {
+    real d = 0;
+
+    for (int i = 0; i < 3; i++)
+      if (p[i] < p1[i])
+        d += (p1[i] - p[i]) * (p1[i] - p[i]);
+      else if (p[i] > p2[i])
+        d += (p[i] - p2[i]) * (p[i] - p2[i]);
+    return d;
+  }
+
+  /// \brief Returns true if the ray r hits this object within
+  /// [r.tMin, r.tMax] and sets t to the distance it enters the box.
+  __host__ __device__
+  bool intersect(const Ray& r, real& t) const
+  {
+    real tNear = r.tMin;
+    real tFar = r.tMax;
+
+    for (int i = 0; i < 3; i++)
+    {
+      const real t1 = ((r.isNegative[i] ? p2 : p1)[i] - r.origin[i]) *
+        r.inverseDirection[i];
+      const real t2 = ((r.isNegative[i] ? p1 : p2)[i] - r.origin[i]) *
+        r.inverseDirection[i];
+
+      // NaNs (0 * inf) fail the comparisons and are ignored
+      if (t1 > tNear)
+        tNear = t1;
+      if (t2 < tFar)
+        tFar = t2;
+    }
+    if (tNear > tFar)
+      return false;
+    t = tNear;
+    return true;
+  }
+
 protected:
   vec3 p1;
   vec3 p2;
 
-}; // Bounds3
+}; // BoundingBox3
+
+typedef BoundingBox3<REAL> Bounds3;
+typedef BoundingBox3<float> Bounds3f;
+typedef BoundingBox3<double> Bounds3d;
 
 } // end namespace Geometry
 
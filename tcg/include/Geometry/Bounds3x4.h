@@ -0,0 +1,189 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Bounds3x4.h
+// ========
+// Class definition for packet of 4 axis-aligned bounding boxes.
+//
+// The packet keeps the boxes in SoA, so that one ray is tested
+// against 4 boxes at once. With float REALs the queries use SSE;
+// otherwise, they loop over the boxes.
+
+#ifndef __Bounds3x4_h
+#define __Bounds3x4_h
+
+#include "Geometry/Bounds3.h"
+#include "Math/BatchTransform.h"
+
+#if defined(DS_SIMD_SSE) && !defined(D_DOUBLE)
+#define DS_BOUNDS_SSE
+#endif
+
+DS_BEGIN_NAMESPACE
+
+namespace Geometry
+{ // begin namespace Geometry
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Bounds3x4: packet of 4 axis-aligned bounding boxes class
+// =========
+class Bounds3x4
+{
+public:
+  REAL p1[3][4]; // min coordinates of the boxes, axis by axis
+  REAL p2[3][4]; // max coordinates of the boxes, axis by axis
+
+  /// Constructs a Bounds3x4 object with 4 empty boxes.
+  Bounds3x4()
+  {
+    setEmpty();
+  }
+
+  void setEmpty()
+  {
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 4; j++)
+      {
+        p1[i][j] = +FloatInfo<REAL>::inf();
+        p2[i][j] = -FloatInfo<REAL>::inf();
+      }
+  }
+
+  /// Sets the j-th box of this object to b.
+  void set(int j, const Bounds3& b)
+  {
+    const vec3& a = b.getMin();
+    const vec3& c = b.getMax();
+
+    p1[0][j] = a.x;
+    p1[1][j] = a.y;
+    p1[2][j] = a.z;
+    p2[0][j] = c.x;
+    p2[1][j] = c.y;
+    p2[2][j] = c.z;
+  }
+
+  /// Returns the j-th box of this object.
+  Bounds3 get(int j) const
+  {
+    if (p1[0][j] > p2[0][j] || p1[1][j] > p2[1][j] || p1[2][j] > p2[2][j])
+      return Bounds3();
+    return Bounds3(vec3(p1[0][j], p1[1][j], p1[2][j]),
+      vec3(p2[0][j], p2[1][j], p2[2][j]));
+  }
+
+  /// \brief Returns a mask whose j-th bit is set if the ray r hits
+  /// the j-th box within [r.tMin, r.tMax]; t[j] is set to the distance
+  /// the ray enters the j-th box.
+  int intersect(const Ray& r, REAL t[4]) const
+  {
+#ifdef DS_BOUNDS_SSE
+    __m128 tNear = _mm_set1_ps(r.tMin);
+    __m128 tFar = _mm_set1_ps(r.tMax);
+
+    for (int i = 0; i < 3; i++)
+    {
+      const __m128 o = _mm_set1_ps(r.origin[i]);
+      const __m128 d = _mm_set1_ps(r.inverseDirection[i]);
+      const float* a = r.isNegative[i] ? p2[i] : p1[i];
+      const float* b = r.isNegative[i] ? p1[i] : p2[i];
+
+      // _mm_max_ps and _mm_min_ps return the second operand if the
+      // first one is NaN (0 * inf), so that NaNs are ignored
+      tNear = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(a), o), d), tNear);
+      tFar = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b), o), d), tFar);
+    }
+    _mm_storeu_ps(t, tNear);
+    return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+#else
+    int mask = 0;
+
+    for (int j = 0; j < 4; j++)
+      if (get(j).intersect(r, t[j]))
+        mask |= 1 << j;
+    return mask;
+#endif // DS_BOUNDS_SSE
+  }
+
+}; // Bounds3x4
+
+/// \brief Returns the number of points p[0..n) inside the box b;
+/// if inside is not null, inside[i] is set to 1 if p[i] is inside b,
+/// or 0 otherwise.
+inline int
+containsPoints(const Bounds3& b, const vec3* p, int n, unsigned char* inside)
+{
+  int count = 0;
+  int i = 0;
+
+#ifdef DS_BOUNDS_SSE
+  const __m128 ax = _mm_set1_ps(b.getMin().x);
+  const __m128 ay = _mm_set1_ps(b.getMin().y);
+  const __m128 az = _mm_set1_ps(b.getMin().z);
+  const __m128 bx = _mm_set1_ps(b.getMax().x);
+  const __m128 by = _mm_set1_ps(b.getMax().y);
+  const __m128 bz = _mm_set1_ps(b.getMax().z);
+
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 x, y, z;
+
+    loadVec3x4(&p[i].x, x, y, z);
+
+    __m128 in = _mm_and_ps(_mm_cmpge_ps(x, ax), _mm_cmple_ps(x, bx));
+
+    in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(y, ay), _mm_cmple_ps(y, by)));
+    in = _mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(z, az), _mm_cmple_ps(z, bz)));
+
+    const int mask = _mm_movemask_ps(in);
+
+    for (int j = 0; j < 4; j++)
+    {
+      const int k = (mask >> j) & 1;
+
+      count += k;
+      if (inside != 0)
+        inside[i + j] = (unsigned char)k;
+    }
+  }
+#endif // DS_BOUNDS_SSE
+  for (; i < n; i++)
+  {
+    const int k = b.contains(p[i]);
+
+    count += k;
+    if (inside != 0)
+      inside[i] = (unsigned char)k;
+  }
+  return count;
+}
+
+} // end namespace Geometry
+
+DS_END_NAMESPACE
+
+#endif // __Bounds3x4_h
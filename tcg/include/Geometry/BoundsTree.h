@@ -0,0 +1,188 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: BoundsTree.h
+// ========
+// Class definition for bounds tree.
+
+#ifndef __BoundsTree_h
+#define __BoundsTree_h
+
+#include "Geometry/Bounds3.h"
+
+DS_BEGIN_NAMESPACE
+
+namespace Geometry
+{ // begin namespace Geometry
+
+#define DFL_BOUNDS_TREE_SIZE 16
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// BoundsTree: bounds tree class
+// ==========
+//
+// A complete binary tree over an array of boxes (the leaves), whose
+// inner nodes are the unions of their children; the root is the
+// union of all boxes. Changing a box marks its ancestors dirty in
+// O(log n) and the dirty nodes are refitted, top-down, only when the
+// union is required. The leaves are contiguous and an unused leaf is
+// an empty box.
+class BoundsTree
+{
+public:
+  /// Constructs an empty BoundsTree object.
+  BoundsTree():
+    capacity(0),
+    numberOfBoxes(0),
+    nodes(0),
+    dirty(0)
+  {
+    // do nothing
+  }
+
+  /// Destructor.
+  ~BoundsTree()
+  {
+    delete []nodes;
+    delete []dirty;
+  }
+
+  /// Returns the number of boxes of this object.
+  int size() const
+  {
+    return numberOfBoxes;
+  }
+
+  /// Returns the boxes of this object.
+  const Bounds3* getBoxes() const
+  {
+    return nodes + capacity;
+  }
+
+  /// Returns the i-th box of this object.
+  const Bounds3& operator [](int i) const
+  {
+    return nodes[capacity + i];
+  }
+
+  /// \brief Returns the boxes of this object to be written in place,
+  /// e.g., in parallel; invalidate() must be called for each box
+  /// written.
+  Bounds3* getBoxes()
+  {
+    return nodes + capacity;
+  }
+
+  /// Sets the i-th box of this object to b.
+  void set(int i, const Bounds3& b)
+  {
+    nodes[capacity + i] = b;
+    invalidate(i);
+  }
+
+  /// Marks the ancestors of the i-th box of this object dirty.
+  void invalidate(int i)
+  {
+    // The ancestors of a dirty node are dirty
+    for (int k = (capacity + i) >> 1; k > 0 && !dirty[k]; k >>= 1)
+      dirty[k] = true;
+  }
+
+  /// Appends the box b to this object and returns its index.
+  int add(const Bounds3& b)
+  {
+    if (numberOfBoxes == capacity)
+      resize(capacity > 0 ? 2 * capacity : DFL_BOUNDS_TREE_SIZE);
+    set(numberOfBoxes, b);
+    return numberOfBoxes++;
+  }
+
+  /// Removes the last box of this object.
+  void removeLast()
+  {
+    set(--numberOfBoxes, Bounds3());
+  }
+
+  /// Removes all boxes of this object.
+  void clear()
+  {
+    while (numberOfBoxes > 0)
+      removeLast();
+  }
+
+  /// Returns the union of the boxes of this object.
+  const Bounds3& getBounds() const
+  {
+    if (capacity == 0)
+      return empty;
+    refit(1);
+    return nodes[1];
+  }
+
+private:
+  int capacity; // number of leaves (a power of two)
+  int numberOfBoxes;
+  mutable Bounds3* nodes; // nodes[1] is the root
+  mutable bool* dirty;
+  Bounds3 empty;
+
+  BoundsTree(const BoundsTree&);
+  BoundsTree& operator =(const BoundsTree&);
+
+  void resize(int n)
+  {
+    Bounds3* temp = new Bounds3[2 * n];
+
+    for (int i = 0; i < numberOfBoxes; i++)
+      temp[n + i] = nodes[capacity + i];
+    delete []nodes;
+    delete []dirty;
+    nodes = temp;
+    dirty = new bool[n];
+    for (int i = 1; i < n; i++)
+      dirty[i] = true;
+    capacity = n;
+  }
+
+  void refit(int k) const
+  {
+    if (k >= capacity || !dirty[k])
+      return;
+    refit(2 * k);
+    refit(2 * k + 1);
+    nodes[k] = nodes[2 * k];
+    nodes[k].inflate(nodes[2 * k + 1]);
+    dirty[k] = false;
+  }
+
+}; // BoundsTree
+
+} // end namespace Geometry
+
+DS_END_NAMESPACE
+
+#endif // __BoundsTree_h
@@ -0,0 +1,194 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Frustum.h
+// ========
+// Class definition for view frustum.
+
+#ifndef __Frustum_h
+#define __Frustum_h
+
+#include "Geometry/Bounds3x4.h"
+
+DS_BEGIN_NAMESPACE
+
+namespace Geometry
+{ // begin namespace Geometry
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Frustum: view frustum class
+// =======
+//
+// The planes are extracted from a projection (or view-projection,
+// or model-view-projection) matrix and point inwards; a point p is
+// inside a plane P if P.x * p.x + P.y * p.y + P.z * p.z + P.w >= 0.
+// The box tests are conservative: a box crossing the extension of
+// a plane, but outside the frustum, may be reported as visible.
+class Frustum
+{
+public:
+  enum
+  {
+    Left,
+    Right,
+    Bottom,
+    Top,
+    Near,
+    Far
+  };
+
+  vec4 planes[6];
+
+  /// Constructs a Frustum object from the clipping matrix m.
+  explicit Frustum(const mat4& m = mat4::identity())
+  {
+    set(m);
+  }
+
+  void set(const mat4& m)
+  {
+    const vec4 r0(m(0, 0), m(0, 1), m(0, 2), m(0, 3));
+    const vec4 r1(m(1, 0), m(1, 1), m(1, 2), m(1, 3));
+    const vec4 r2(m(2, 0), m(2, 1), m(2, 2), m(2, 3));
+    const vec4 r3(m(3, 0), m(3, 1), m(3, 2), m(3, 3));
+
+    planes[Left] = r3 + r0;
+    planes[Right] = r3 - r0;
+    planes[Bottom] = r3 + r1;
+    planes[Top] = r3 - r1;
+    planes[Near] = r3 + r2;
+    planes[Far] = r3 - r2;
+    // Normalized planes give distances, used by the sphere test
+    for (int i = 0; i < 6; i++)
+    {
+      const REAL len = vec3(planes[i]).length();
+
+      if (!Math::isZero<REAL>(len))
+        planes[i] *= Math::inverse<REAL>(len);
+    }
+  }
+
+  /// Returns true if the sphere (c, r) is outside this object.
+  bool isOutside(const vec3& c, REAL r) const
+  {
+    for (int i = 0; i < 6; i++)
+    {
+      const vec4& P = planes[i];
+
+      if (P.x * c.x + P.y * c.y + P.z * c.z + P.w < -r)
+        return true;
+    }
+    return false;
+  }
+
+  /// Returns true if the box b is outside this object.
+  bool isOutside(const Bounds3& b) const
+  {
+    const vec3& a = b.getMin();
+    const vec3& c = b.getMax();
+
+    // Test the corner of the box farthest along the plane normal
+    for (int i = 0; i < 6; i++)
+    {
+      const vec4& P = planes[i];
+      const REAL x = P.x >= 0 ? c.x : a.x;
+      const REAL y = P.y >= 0 ? c.y : a.y;
+      const REAL z = P.z >= 0 ? c.z : a.z;
+
+      if (P.x * x + P.y * y + P.z * z + P.w < 0)
+        return true;
+    }
+    return false;
+  }
+
+  /// \brief Returns a mask whose j-th bit is set if the j-th box of
+  /// the packet b is not outside this object.
+  int intersect(const Bounds3x4& b) const
+  {
+#ifdef DS_BOUNDS_SSE
+    __m128 out = _mm_setzero_ps();
+
+    for (int i = 0; i < 6; i++)
+    {
+      const vec4& P = planes[i];
+      const __m128 x = _mm_loadu_ps(P.x >= 0 ? b.p2[0] : b.p1[0]);
+      const __m128 y = _mm_loadu_ps(P.y >= 0 ? b.p2[1] : b.p1[1]);
+      const __m128 z = _mm_loadu_ps(P.z >= 0 ? b.p2[2] : b.p1[2]);
+      __m128 d = _mm_mul_ps(x, _mm_set1_ps(P.x));
+
+      d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(P.y)));
+      d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(P.z)));
+      d = _mm_add_ps(d, _mm_set1_ps(P.w));
+      out = _mm_or_ps(out, _mm_cmplt_ps(d, _mm_setzero_ps()));
+    }
+    return ~_mm_movemask_ps(out) & 15;
+#else
+    int mask = 0;
+
+    for (int j = 0; j < 4; j++)
+      if (!isOutside(b.get(j)))
+        mask |= 1 << j;
+    return mask;
+#endif // DS_BOUNDS_SSE
+  }
+
+  /// \brief Returns the number of boxes b[0..n) not outside this
+  /// object; if visible is not null, visible[i] is set to 1 if b[i]
+  /// is not outside, or 0 otherwise.
+  int cull(const Bounds3* b, int n, unsigned char* visible) const
+  {
+    int count = 0;
+
+    for (int i = 0; i < n; i += 4)
+    {
+      const int m = n - i < 4 ? n - i : 4;
+      Bounds3x4 packet;
+
+      for (int j = 0; j < m; j++)
+        packet.set(j, b[i + j]);
+
+      const int mask = intersect(packet);
+
+      for (int j = 0; j < m; j++)
+      {
+        const int k = (mask >> j) & 1;
+
+        count += k;
+        if (visible != 0)
+          visible[i + j] = (unsigned char)k;
+      }
+    }
+    return count;
+  }
+
+}; // Frustum
+
+} // end namespace Geometry
+
+DS_END_NAMESPACE
+
+#endif // __Frustum_h
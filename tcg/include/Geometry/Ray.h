@@ -0,0 +1,115 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Ray.h
+// ========
+// Class definition for ray.
+
+#ifndef __Ray_h
+#define __Ray_h
+
+#include "Math/Matrix4x4.h"
+
+DS_BEGIN_NAMESPACE
+
+namespace Geometry
+{ // begin namespace Geometry
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Ray3: ray class
+// ====
+//
+// The inverse of the direction and its signs are kept for the
+// slab tests against boxes.
+template <typename real>
+class Ray3
+{
+public:
+  typedef Vector3<real> vec3;
+  typedef Matrix4x4<real> mat4;
+
+  vec3 origin;
+  vec3 direction;
+  vec3 inverseDirection;
+  int isNegative[3];
+  real tMin;
+  real tMax;
+
+  /// Constructs a Ray3 object.
+  __host__ __device__
+  Ray3(const vec3& origin,
+    const vec3& direction,
+    real tMin = 0,
+    real tMax = FloatInfo<real>::inf())
+  {
+    set(origin, direction, tMin, tMax);
+  }
+
+  __host__ __device__
+  void set(const vec3& origin,
+    const vec3& direction,
+    real tMin = 0,
+    real tMax = FloatInfo<real>::inf())
+  {
+    this->origin = origin;
+    this->direction = direction;
+    // A zero coordinate yields an infinite inverse
+    inverseDirection.x = 1 / direction.x;
+    inverseDirection.y = 1 / direction.y;
+    inverseDirection.z = 1 / direction.z;
+    isNegative[0] = direction.x < 0;
+    isNegative[1] = direction.y < 0;
+    isNegative[2] = direction.z < 0;
+    this->tMin = tMin;
+    this->tMax = tMax;
+  }
+
+  /// Returns the point of this object at t.
+  __host__ __device__
+  vec3 operator ()(real t) const
+  {
+    return origin + direction * t;
+  }
+
+  /// Transforms this object by the affine matrix m.
+  __host__ __device__
+  void transform(const mat4& m)
+  {
+    set(m.transform3x4(origin), m.transformVector(direction), tMin, tMax);
+  }
+
+}; // Ray3
+
+typedef Ray3<REAL> Ray;
+typedef Ray3<float> Rayf;
+typedef Ray3<double> Rayd;
+
+} // end namespace Geometry
+
+DS_END_NAMESPACE
+
+#endif // __Ray_h
@@ -15,6 +15,9 @@
 // ========
 // Class definition for generic doubly linked list.
 
+#include <new>
+#include <type_traits>
+
 namespace System
 { // begin namespace System
 
@@ -52,7 +55,9 @@ removeNode(T* node, T*& head)
 //
 template <typename T> class ListImp;
 template <typename T> class ListIteratorImp;
-template <typename T> class List;
+template <typename T> class ListElement;
+template <typename T> class ListPool;
+template <typename T, typename A = ListPool<ListElement<T> > > class List;
 template <typename T> class ListIterator;
 
 
@@ -324,12 +329,156 @@ public:
 
 }; // ListElement
 
+#define DFL_LIST_POOL_SLAB 16
+#define MAX_LIST_POOL_SLAB 1024
+
+
+//////////////////////////////////////////////////////////
+//
+// ListPool: list node allocator class
+// ========
+//
+// Nodes are carved out of slabs by a pointer bump and freed
+// nodes are recycled through a free list, so that the nodes of
+// a list sit near each other in memory. The slab sizes grow
+// geometrically from DFL_LIST_POOL_SLAB up to MAX_LIST_POOL_SLAB
+// nodes. The slabs are released only by clear() and by the
+// destructor, when no node is in use.
+//
+template <typename T>
+class ListPool
+{
+public:
+  // Constructor
+  ListPool():
+    slabs(0),
+    freeList(0),
+    next(0),
+    end(0),
+    slabSize(DFL_LIST_POOL_SLAB)
+  {
+    // do nothing
+  }
+
+  // Destructor
+  ~ListPool()
+  {
+    clear();
+  }
+
+  void* allocate()
+  {
+    Slot* slot = freeList;
+
+    if (slot != 0)
+      freeList = slot->next;
+    else
+    {
+      if (next == end)
+        newSlab();
+      slot = next++;
+    }
+    return slot;
+  }
+
+  void deallocate(void* p)
+  {
+    Slot* slot = (Slot*)p;
+
+    slot->next = freeList;
+    freeList = slot;
+  }
+
+  void clear();
+
+private:
+  // The first slot of a slab links the slabs
+  union Slot
+  {
+    Slot* next;
+    typename std::aligned_storage<sizeof(T),
+      std::alignment_of<T>::value>::type node;
+
+  }; // Slot
+
+  Slot* slabs;
+  Slot* freeList;
+  Slot* next;
+  Slot* end;
+  int slabSize;
+
+  ListPool(const ListPool<T>&);
+  ListPool<T>& operator =(const ListPool<T>&);
+
+  void newSlab();
+
+}; // ListPool
+
+template <typename T>
+void
+ListPool<T>::newSlab()
+{
+  Slot* slab = new Slot[slabSize + 1];
+
+  slab->next = slabs;
+  slabs = slab;
+  next = slab + 1;
+  end = next + slabSize;
+  if (slabSize < MAX_LIST_POOL_SLAB)
+    slabSize <<= 1;
+}
+
+template <typename T>
+void
+ListPool<T>::clear()
+{
+  while (slabs != 0)
+  {
+    Slot* temp = slabs;
+
+    slabs = slabs->next;
+    delete []temp;
+  }
+  freeList = next = end = 0;
+  slabSize = DFL_LIST_POOL_SLAB;
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// ListHeap: list node allocator class (one node per new)
+// ========
+template <typename T>
+class ListHeap
+{
+public:
+  void* allocate()
+  {
+    return ::operator new(sizeof(T));
+  }
+
+  void deallocate(void* p)
+  {
+    ::operator delete(p);
+  }
+
+  void clear()
+  {
+    // do nothing
+  }
+
+}; // ListHeap
+
 
 //////////////////////////////////////////////////////////
 //
 // List: generic list class
 // ====
-template <typename T>
+//
+// The nodes of a list are allocated by its own allocator of
+// type A, a ListPool by default.
+//
+template <typename T, typename A>
 class List
 {
 public:
@@ -339,14 +488,20 @@ public:
     // do nothing
   }
 
+  // Destructor
+  ~List()
+  {
+    clear();
+  }
+
   void addAtHead(const T& t)
   {
-    imp.addAtHead(new ListElement<T>(t));
+    imp.addAtHead(new(allocator.allocate()) ListElement<T>(t));
   }
 
   void addAtTail(const T& t)
   {
-    imp.addAtTail(new ListElement<T>(t));
+    imp.addAtTail(new(allocator.allocate()) ListElement<T>(t));
   }
 
   void add(const T& t)
@@ -357,10 +512,7 @@ public:
   bool remove(const T&);
   bool removeHead();
 
-  void clear()
-  {
-    imp.clear();
-  }
+  void clear();
 
   bool contains(const T& t) const
   {
@@ -381,17 +533,19 @@ public:
 
 protected:
   ListImp<ListElement<T> > imp;
+  A allocator;
 
 private:
-  List(const List<T>&);
-  List<T>& operator =(const List<T>&);
+  List(const List<T, A>&);
+  List<T, A>& operator =(const List<T, A>&);
 
   ListElement<T>* find(const T&) const;
 
   void remove(ListElement<T>* e)
   {
     imp.remove(*e);
-    delete e;
+    e->~ListElement<T>();
+    allocator.deallocate(e);
   }
 
   friend class ListIterator<T>;
@@ -408,7 +562,8 @@ class ListIterator
 {
 public:
   // Constructor
-  ListIterator(const List<T>& list):
+  template <typename A>
+  ListIterator(const List<T, A>& list):
     imp(list.imp)
   {
     // do nothing
@@ -463,9 +618,9 @@ private:
 //
 // List implementation
 // ====
-template <typename T>
+template <typename T, typename A>
 bool
-List<T>::remove(const T& t)
+List<T, A>::remove(const T& t)
 {
   ListElement<T>* temp = find(t);
 
@@ -475,29 +630,40 @@ List<T>::remove(const T& t)
   return true;
 }
 
-template <typename T>
+template <typename T, typename A>
 bool
-List<T>::removeHead()
+List<T, A>::removeHead()
 {
-  if (imp.head == 0)
+  ListElement<T>* head = imp.peekHead();
+
+  if (head == 0)
     return false;
-  remove(imp.head);
+  remove(head);
   return true;
 }
 
-template <typename T>
+template <typename T, typename A>
+void
+List<T, A>::clear()
+{
+  while (ListElement<T>* head = imp.peekHead())
+    remove(head);
+  allocator.clear();
+}
+
+template <typename T, typename A>
 ListElement<T>*
-List<T>::find(const T& t) const
+List<T, A>::find(const T& t) const
 {
-  for (ListElement<T>* e = imp.head; e; e = e->next)
+  for (ListElement<T>* e = imp.peekHead(); e; e = e->next)
     if (e->value == t)
       return e;
   return 0;
 }
 
-template <typename T>
+template <typename T, typename A>
 inline ListIterator<T>
-List<T>::iterator() const
+List<T, A>::iterator() const
 {
   return ListIterator<T>(*this);
 }
@@ -0,0 +1,432 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: BatchTransform.h
+// ========
+// Batch transformation of arrays of points, vectors, and normals,
+// and batch computation of face normals from gathered (SoA) points.
+//
+// The output array can be the input array itself. Arrays with at
+// least DS_BATCH_PARALLEL_MIN elements are split into chunks of
+// DS_BATCH_CHUNK elements transformed in parallel (OpenMP).
+
+#ifndef __BatchTransform_h
+#define __BatchTransform_h
+
+#include "Math/Matrix4x4.h"
+
+DS_BEGIN_NAMESPACE
+
+#define DS_BATCH_PARALLEL_MIN 16384
+#define DS_BATCH_CHUNK 4096
+
+
+/// \brief Sets N to the unit normal and len to the length of the
+/// cross product of the edges of the triangle whose corners are
+/// given by the streams s (see BatchKernel::faceNormals()). A null
+/// cross product is not normalized.
+template <typename real>
+inline void
+faceNormal(const real* s, int size, Vector3<real>& N, real& len)
+{
+  const Vector3<real> p0(s[0], s[size], s[2 * size]);
+  const Vector3<real> p1(s[3 * size], s[4 * size], s[5 * size]);
+  const Vector3<real> p2(s[6 * size], s[7 * size], s[8 * size]);
+
+  N = (p1 - p0).cross(p2 - p0);
+  len = N.length();
+  if (!Math::isZero<real>(len))
+    N *= Math::inverse<real>(len);
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// BatchKernel: sequential batch transformation kernels
+// ===========
+template <typename real>
+struct BatchKernel
+{
+  typedef Vector3<real> vec3;
+  typedef Matrix3x3<real> mat3;
+  typedef Matrix4x4<real> mat4;
+
+  static void points(const mat4& m, const vec3* p, vec3* q, int n)
+  {
+    for (int i = 0; i < n; i++)
+      q[i] = m.transform3x4(p[i]);
+  }
+
+  static void vectors(const mat4& m, const vec3* v, vec3* q, int n)
+  {
+    for (int i = 0; i < n; i++)
+      q[i] = m.transformVector(v[i]);
+  }
+
+  static void normals(const mat3& m, const vec3* N, vec3* q, int n)
+  {
+    for (int i = 0; i < n; i++)
+      q[i] = m.transform(N[i]).versor();
+  }
+
+  // Gather the points p[index[stride * i]] into 3 streams of size
+  // elements: x, y, and z
+  static void gather(const vec3* p,
+    const int* index,
+    int stride,
+    real* s,
+    int size,
+    int n)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      const vec3& q = p[index[stride * i]];
+
+      s[i] = q.x;
+      s[size + i] = q.y;
+      s[2 * size + i] = q.z;
+    }
+  }
+
+  // The corners of the triangles are 9 streams of size elements:
+  // x, y, and z of the first corner, then of the second and third
+  static void faceNormals(const real* s, int size, vec3* N, real* len, int n)
+  {
+    for (int i = 0; i < n; i++)
+      faceNormal(s + i, size, N[i], len[i]);
+  }
+
+}; // BatchKernel
+
+#ifdef DS_SIMD_SSE
+
+/// \brief Loads 4 vec3s (12 floats) and returns their coordinates
+/// in x, y, and z (AoS to SoA).
+inline void
+loadVec3x4(const float* p, __m128& x, __m128& y, __m128& z)
+{
+  const __m128 a0 = _mm_loadu_ps(p); // x0 y0 z0 x1
+  const __m128 a1 = _mm_loadu_ps(p + 4); // y1 z1 x2 y2
+  const __m128 a2 = _mm_loadu_ps(p + 8); // z2 x3 y3 z3
+  const __m128 t = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(1, 0, 2, 2));
+
+  x = _mm_shuffle_ps(a0, t, _MM_SHUFFLE(3, 0, 3, 0));
+  y = _mm_shuffle_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(0, 0, 1, 1)),
+    _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2, 2, 3, 3)),
+    _MM_SHUFFLE(2, 0, 2, 0));
+  z = _mm_shuffle_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 1, 2, 2)),
+    _mm_shuffle_ps(a2, a2, _MM_SHUFFLE(3, 3, 0, 0)),
+    _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/// Stores the coordinates x, y, and z as 4 vec3s (SoA to AoS).
+inline void
+storeVec3x4(float* p, __m128 x, __m128 y, __m128 z)
+{
+  const __m128 x0y0 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+  const __m128 z0x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+  const __m128 y1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+  const __m128 x2y2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+  const __m128 z2x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+  const __m128 y3z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+  _mm_storeu_ps(p, _mm_shuffle_ps(x0y0, z0x1, _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(p + 4, _mm_shuffle_ps(y1z1, x2y2, _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(p + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+/// Loads a vec3 (3 floats) into (x, y, z, 0) without reading past it.
+inline __m128
+loadVec3(const float* p)
+{
+  return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)p),
+    _mm_load_ss(p + 2));
+}
+
+/// \brief Broadcasts the elements of the 3x3 part of the column-major
+/// matrix m to r, row by row.
+inline void
+broadcast3x3(const float* m, int stride, __m128 r[9])
+{
+  for (int j = 0; j < 3; j++)
+    for (int i = 0; i < 3; i++)
+      r[3 * i + j] = _mm_set1_ps(m[stride * j + i]);
+}
+
+/// Sets (x, y, z) to the broadcast 3x3 matrix m times (x, y, z).
+inline void
+mul3x3(const __m128 m[9], __m128& x, __m128& y, __m128& z)
+{
+  const __m128 a = x;
+  const __m128 b = y;
+  const __m128 c = z;
+
+  x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], a), _mm_mul_ps(m[1], b)),
+    _mm_mul_ps(m[2], c));
+  y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[3], a), _mm_mul_ps(m[4], b)),
+    _mm_mul_ps(m[5], c));
+  z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[6], a), _mm_mul_ps(m[7], b)),
+    _mm_mul_ps(m[8], c));
+}
+
+/// SSE kernels: 4 elements per iteration, the remainder is scalar.
+template <>
+struct BatchKernel<float>
+{
+  typedef Vector3<float> vec3;
+  typedef Matrix3x3<float> mat3;
+  typedef Matrix4x4<float> mat4;
+
+  static void points(const mat4& m, const vec3* p, vec3* q, int n)
+  {
+    __m128 r[9];
+    const __m128 tx = _mm_set1_ps(m[3].x);
+    const __m128 ty = _mm_set1_ps(m[3].y);
+    const __m128 tz = _mm_set1_ps(m[3].z);
+    int i = 0;
+
+    broadcast3x3(&m[0].x, 4, r);
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 x, y, z;
+
+      loadVec3x4(&p[i].x, x, y, z);
+      mul3x3(r, x, y, z);
+      storeVec3x4(&q[i].x,
+        _mm_add_ps(x, tx),
+        _mm_add_ps(y, ty),
+        _mm_add_ps(z, tz));
+    }
+    for (; i < n; i++)
+      q[i] = m.transform3x4(p[i]);
+  }
+
+  static void vectors(const mat4& m, const vec3* v, vec3* q, int n)
+  {
+    __m128 r[9];
+    int i = 0;
+
+    broadcast3x3(&m[0].x, 4, r);
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 x, y, z;
+
+      loadVec3x4(&v[i].x, x, y, z);
+      mul3x3(r, x, y, z);
+      storeVec3x4(&q[i].x, x, y, z);
+    }
+    for (; i < n; i++)
+      q[i] = m.transformVector(v[i]);
+  }
+
+  static void normals(const mat3& m, const vec3* N, vec3* q, int n)
+  {
+    // Vectors whose length is not greater than eps are not normalized,
+    // as in vec3::normalize()
+    const float eps = FloatInfo<float>::eps();
+    const __m128 eps2 = _mm_set1_ps(eps * eps);
+    const __m128 one = _mm_set1_ps(1);
+    __m128 r[9];
+    int i = 0;
+
+    broadcast3x3(m.data(), 3, r);
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 x, y, z;
+
+      loadVec3x4(&N[i].x, x, y, z);
+      mul3x3(r, x, y, z);
+
+      const __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x),
+        _mm_mul_ps(y, y)),
+        _mm_mul_ps(z, z));
+      const __m128 mask = _mm_cmpgt_ps(len2, eps2);
+      const __m128 s = _mm_or_ps(_mm_and_ps(mask,
+        _mm_div_ps(one, _mm_sqrt_ps(len2))),
+        _mm_andnot_ps(mask, one));
+
+      storeVec3x4(&q[i].x,
+        _mm_mul_ps(x, s),
+        _mm_mul_ps(y, s),
+        _mm_mul_ps(z, s));
+    }
+    for (; i < n; i++)
+      q[i] = m.transform(N[i]).versor();
+  }
+
+  static void gather(const vec3* p,
+    const int* index,
+    int stride,
+    float* s,
+    int size,
+    int n)
+  {
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+      const int* k = index + stride * i;
+      __m128 x = loadVec3(&p[k[0]].x);
+      __m128 y = loadVec3(&p[k[stride]].x);
+      __m128 z = loadVec3(&p[k[2 * stride]].x);
+      __m128 w = loadVec3(&p[k[3 * stride]].x);
+
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+      _mm_storeu_ps(s + i, x);
+      _mm_storeu_ps(s + size + i, y);
+      _mm_storeu_ps(s + 2 * size + i, z);
+    }
+    for (; i < n; i++)
+    {
+      const vec3& q = p[index[stride * i]];
+
+      s[i] = q.x;
+      s[size + i] = q.y;
+      s[2 * size + i] = q.z;
+    }
+  }
+
+  static void faceNormals(const float* s, int size, vec3* N, float* len, int n)
+  {
+    // Cross products whose length is not greater than eps are not
+    // normalized, as in faceNormal()
+    const __m128 eps = _mm_set1_ps(FloatInfo<float>::eps());
+    const __m128 one = _mm_set1_ps(1);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+      const float* p = s + i;
+      const __m128 x0 = _mm_loadu_ps(p);
+      const __m128 y0 = _mm_loadu_ps(p + size);
+      const __m128 z0 = _mm_loadu_ps(p + 2 * size);
+      const __m128 ax = _mm_sub_ps(_mm_loadu_ps(p + 3 * size), x0);
+      const __m128 ay = _mm_sub_ps(_mm_loadu_ps(p + 4 * size), y0);
+      const __m128 az = _mm_sub_ps(_mm_loadu_ps(p + 5 * size), z0);
+      const __m128 bx = _mm_sub_ps(_mm_loadu_ps(p + 6 * size), x0);
+      const __m128 by = _mm_sub_ps(_mm_loadu_ps(p + 7 * size), y0);
+      const __m128 bz = _mm_sub_ps(_mm_loadu_ps(p + 8 * size), z0);
+      const __m128 x = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+      const __m128 y = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+      const __m128 z = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+      const __m128 l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x),
+        _mm_mul_ps(y, y)),
+        _mm_mul_ps(z, z)));
+      const __m128 mask = _mm_cmpgt_ps(l, eps);
+      const __m128 r = _mm_or_ps(_mm_and_ps(mask, _mm_div_ps(one, l)),
+        _mm_andnot_ps(mask, one));
+
+      storeVec3x4(&N[i].x,
+        _mm_mul_ps(x, r),
+        _mm_mul_ps(y, r),
+        _mm_mul_ps(z, r));
+      _mm_storeu_ps(len + i, l);
+    }
+    for (; i < n; i++)
+      faceNormal(s + i, size, N[i], len[i]);
+  }
+
+}; // BatchKernel<float>
+
+#endif // DS_SIMD_SSE
+
+/// \brief Transforms the points p[0..n) by the affine matrix m and
+/// stores them in q[0..n).
+template <typename real>
+inline void
+transformPoints(const Matrix4x4<real>& m,
+  const Vector3<real>* p,
+  Vector3<real>* q,
+  int n,
+  bool parallel = true)
+{
+  if (!parallel || n < DS_BATCH_PARALLEL_MIN)
+  {
+    BatchKernel<real>::points(m, p, q, n);
+    return;
+  }
+#pragma omp parallel for
+  for (int i = 0; i < n; i += DS_BATCH_CHUNK)
+    BatchKernel<real>::points(m, p + i, q + i,
+      n - i < DS_BATCH_CHUNK ? n - i : DS_BATCH_CHUNK);
+}
+
+/// \brief Transforms the vectors v[0..n) by the 3x3 part of the
+/// matrix m and stores them in q[0..n).
+template <typename real>
+inline void
+transformVectors(const Matrix4x4<real>& m,
+  const Vector3<real>* v,
+  Vector3<real>* q,
+  int n,
+  bool parallel = true)
+{
+  if (!parallel || n < DS_BATCH_PARALLEL_MIN)
+  {
+    BatchKernel<real>::vectors(m, v, q, n);
+    return;
+  }
+#pragma omp parallel for
+  for (int i = 0; i < n; i += DS_BATCH_CHUNK)
+    BatchKernel<real>::vectors(m, v + i, q + i,
+      n - i < DS_BATCH_CHUNK ? n - i : DS_BATCH_CHUNK);
+}
+
+/// \brief Transforms the normals N[0..n) by the normal matrix m
+/// and stores the normalized results in q[0..n).
+template <typename real>
+inline void
+transformNormals(const Matrix3x3<real>& m,
+  const Vector3<real>* N,
+  Vector3<real>* q,
+  int n,
+  bool parallel = true)
+{
+  if (!parallel || n < DS_BATCH_PARALLEL_MIN)
+  {
+    BatchKernel<real>::normals(m, N, q, n);
+    return;
+  }
+#pragma omp parallel for
+  for (int i = 0; i < n; i += DS_BATCH_CHUNK)
+    BatchKernel<real>::normals(m, N + i, q + i,
+      n - i < DS_BATCH_CHUNK ? n - i : DS_BATCH_CHUNK);
+}
+
+/// \brief Returns the normal matrix of m, i.e., the inverse transposed
+/// of the 3x3 part of m, or the 3x3 part itself if it is singular.
+template <typename real>
+inline Matrix3x3<real>
+normalMatrix(const Matrix4x4<real>& m)
+{
+  Matrix3x3<real> n(m);
+
+  n.invert();
+  return n.transpose();
+}
+
+DS_END_NAMESPACE
+
+#endif // __BatchTransform_h
@@ -103,6 +103,14 @@ public:
     set(m);
   }
 
+  /// Constructs a Matrix3x3 object from m of another precision.
+  template <typename T>
+  __host__ __device__
+  explicit Matrix3x3(const Matrix3x3<T>& m)
+  {
+    set(vec3(m[0]), vec3(m[1]), vec3(m[2]));
+  }
+
   /// Sets this object to m.
   __host__ __device__
   void set(const mat3& m)
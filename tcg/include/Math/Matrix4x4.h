@@ -34,6 +34,7 @@
 #define __Matrix4x4_h
 
 #include "Math/Matrix3x3.h"
+#include "Math/SIMD.h"
 #include "Math/Vector4.h"
 
 DS_BEGIN_NAMESPACE
@@ -107,6 +108,14 @@ public:
     set(r, p);
   }
 
+  /// Constructs a Matrix4x4 object from m of another precision.
+  template <typename T>
+  __host__ __device__
+  explicit Matrix4x4(const Matrix4x4<T>& m)
+  {
+    set(vec4(m[0]), vec4(m[1]), vec4(m[2]), vec4(m[3]));
+  }
+
   /// Sets this object to m.
   __host__ __device__
   void set(const mat4& m)
@@ -346,6 +355,35 @@ public:
     return (m = *this).invert(eps);
   }
 
+  /// Returns true if the last row of this object is [0 0 0 1].
+  __host__ __device__
+  bool isAffine() const
+  {
+    return v0.w == 0 && v1.w == 0 && v2.w == 0 && v3.w == 1;
+  }
+
+  /// \brief Tries to invert this object, which must be an affine
+  /// transformation, and returns true on success; otherwise, leaves
+  /// this object unchanged and returns false. This method is faster
+  /// than invert, since only the 3x3 part is inverted.
+  __host__ __device__
+  bool invertAffine(real eps = FloatInfo<real>::eps())
+  {
+    mat3 r(*this);
+
+    if (!r.invert(eps))
+      return false;
+    set(r, -(r * vec3(v3)));
+    return true;
+  }
+
+  /// Assigns this object to m and tries to invert m (affine).
+  __host__ __device__
+  bool inverseAffine(mat4& m, real eps = FloatInfo<real>::eps()) const
+  {
+    return (m = *this).invertAffine(eps);
+  }
+
   /// Returns a position p transformed by this object.
   __host__ __device__
   vec4 transform(const vec4& p) const
@@ -401,6 +439,25 @@ public:
     return TRS(p, quat::eulerAngles(angles), s);
   }
 
+  /// \brief Returns the inverse of a translation, rotation, and scaling
+  /// matrix, i.e., S^-1 * R^T * T^-1 (no scale factor can be zero).
+  __host__ __device__
+  static mat4 inverseTRS(const vec3& p, const quat& q, const vec3& s)
+  {
+    const mat3 r(q);
+    const mat3 a = mat3(r[0] * ((real)1 / s.x),
+      r[1] * ((real)1 / s.y),
+      r[2] * ((real)1 / s.z)).transposed();
+
+    return mat4(a, -(a * p));
+  }
+
+  __host__ __device__
+  static mat4 inverseTRS(const vec3& p, const vec3& angles, const vec3& s)
+  {
+    return inverseTRS(p, quat::eulerAngles(angles), s);
+  }
+
   /// Sets this object as a TRS matrix.
   __host__ __device__
   void setTRS(const vec3& p, const quat& q, const vec3& s)
@@ -568,6 +625,126 @@ Matrix3x3<real>::set(const Matrix4x4<real>& m) // declared in Matrix3x3.h
   v2 = m.v2;
 }
 
+//
+// SIMD specializations. The columns are loaded unaligned, since
+// matrices are embedded in objects and arrays with no particular
+// alignment (unaligned loads of aligned data cost the same on any
+// processor supporting AVX).
+//
+#ifdef DS_SIMD_SSE
+
+/// Returns c0 * b[0] + c1 * b[1] + c2 * b[2] + c3 * b[3].
+inline __m128
+combine4(__m128 c0, __m128 c1, __m128 c2, __m128 c3, const float* b)
+{
+  __m128 r = _mm_mul_ps(c0, _mm_set1_ps(b[0]));
+
+  r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+  r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(b[2])));
+  return _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(b[3])));
+}
+
+template <>
+inline Matrix4x4<float>
+Matrix4x4<float>::operator *(const mat4& m) const
+{
+  const __m128 c0 = _mm_loadu_ps(&v0.x);
+  const __m128 c1 = _mm_loadu_ps(&v1.x);
+  const __m128 c2 = _mm_loadu_ps(&v2.x);
+  const __m128 c3 = _mm_loadu_ps(&v3.x);
+  mat4 r;
+
+  for (int j = 0; j < 4; j++)
+    _mm_storeu_ps(&r[j].x, combine4(c0, c1, c2, c3, &m[j].x));
+  return r;
+}
+
+template <>
+inline Vector4<float>
+Matrix4x4<float>::transform(const vec4& p) const
+{
+  vec4 r;
+
+  _mm_storeu_ps(&r.x, combine4(_mm_loadu_ps(&v0.x),
+    _mm_loadu_ps(&v1.x),
+    _mm_loadu_ps(&v2.x),
+    _mm_loadu_ps(&v3.x),
+    &p.x));
+  return r;
+}
+
+template <>
+inline Vector3<float>
+Matrix4x4<float>::transform3x4(const vec3& p) const
+{
+  __m128 r = _mm_mul_ps(_mm_loadu_ps(&v0.x), _mm_set1_ps(p.x));
+  float t[4];
+
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&v1.x), _mm_set1_ps(p.y)));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&v2.x), _mm_set1_ps(p.z)));
+  _mm_storeu_ps(t, _mm_add_ps(r, _mm_loadu_ps(&v3.x)));
+  return vec3(t[0], t[1], t[2]);
+}
+
+#endif // DS_SIMD_SSE
+
+#ifdef DS_SIMD_AVX
+
+/// Returns c0 * b[0] + c1 * b[1] + c2 * b[2] + c3 * b[3].
+inline __m256d
+combine4(__m256d c0, __m256d c1, __m256d c2, __m256d c3, const double* b)
+{
+  __m256d r = _mm256_mul_pd(c0, _mm256_set1_pd(b[0]));
+
+  r = _mm256_add_pd(r, _mm256_mul_pd(c1, _mm256_set1_pd(b[1])));
+  r = _mm256_add_pd(r, _mm256_mul_pd(c2, _mm256_set1_pd(b[2])));
+  return _mm256_add_pd(r, _mm256_mul_pd(c3, _mm256_set1_pd(b[3])));
+}
+
+template <>
+inline Matrix4x4<double>
+Matrix4x4<double>::operator *(const mat4& m) const
+{
+  const __m256d c0 = _mm256_loadu_pd(&v0.x);
+  const __m256d c1 = _mm256_loadu_pd(&v1.x);
+  const __m256d c2 = _mm256_loadu_pd(&v2.x);
+  const __m256d c3 = _mm256_loadu_pd(&v3.x);
+  mat4 r;
+
+  for (int j = 0; j < 4; j++)
+    _mm256_storeu_pd(&r[j].x, combine4(c0, c1, c2, c3, &m[j].x));
+  return r;
+}
+
+template <>
+inline Vector4<double>
+Matrix4x4<double>::transform(const vec4& p) const
+{
+  vec4 r;
+
+  _mm256_storeu_pd(&r.x, combine4(_mm256_loadu_pd(&v0.x),
+    _mm256_loadu_pd(&v1.x),
+    _mm256_loadu_pd(&v2.x),
+    _mm256_loadu_pd(&v3.x),
+    &p.x));
+  return r;
+}
+
+template <>
+inline Vector3<double>
+Matrix4x4<double>::transform3x4(const vec3& p) const
+{
+  __m256d r = _mm256_mul_pd(_mm256_loadu_pd(&v0.x), _mm256_set1_pd(p.x));
+  double t[4];
+
+  r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(&v1.x), _mm256_set1_pd(p.y)));
+  r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_loadu_pd(&v2.x), _mm256_set1_pd(p.z)));
+  _mm256_storeu_pd(t, _mm256_add_pd(r, _mm256_loadu_pd(&v3.x)));
+  return vec3(t[0], t[1], t[2]);
+}
+
+#endif // DS_SIMD_AVX
+
 DS_END_NAMESPACE
 
 /// Default mat4 type.
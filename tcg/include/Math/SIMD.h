@@ -0,0 +1,48 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2014 Orthrus Group.                               |
+//|                                                                 |
+//| This software is provided 'as-is', without any express or       |
+//| implied warranty. In no event will the authors be held liable   |
+//| for any damages arising from the use of this software.          |
+//|                                                                 |
+//| Permission is granted to anyone to use this software for any    |
+//| purpose, including commercial applications, and to alter it and |
+//| redistribute it freely, subject to the following restrictions:  |
+//|                                                                 |
+//| 1. The origin of this software must not be misrepresented; you  |
+//| must not claim that you wrote the original software. If you use |
+//| this software in a product, an acknowledgment in the product    |
+//| documentation would be appreciated but is not required.         |
+//|                                                                 |
+//| 2. Altered source versions must be plainly marked as such, and  |
+//| must not be misrepresented as being the original software.      |
+//|                                                                 |
+//| 3. This notice may not be removed or altered from any source    |
+//| distribution.                                                   |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: SIMD.h
+// ========
+// Compile-time switch for SIMD code.
+//
+// SSE is used for float and AVX for double when the compiler
+// targets them; define DS_NO_SIMD to keep the scalar code only.
+
+#ifndef __SIMD_h
+#define __SIMD_h
+
+#if !defined(DS_NO_SIMD) && !defined(__CUDACC__)
+#if defined(__SSE__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DS_SIMD_SSE
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+#define DS_SIMD_AVX
+#include <immintrin.h>
+#endif
+#endif // !DS_NO_SIMD && !__CUDACC__
+
+#endif // __SIMD_h
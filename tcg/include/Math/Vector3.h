@@ -94,6 +94,14 @@ public:
     set(v);
   }
 
+  /// Constructs a Vector3 object from v of another precision.
+  template <typename T>
+  __host__ __device__
+  explicit Vector3(const Vector3<T>& v)
+  {
+    set(real(v.x), real(v.y), real(v.z));
+  }
+
   /// Sets this object to v.
   __host__ __device__
   void set(const vec3& v)
@@ -89,6 +89,14 @@ public:
     set(v, w);
   }
 
+  /// Constructs a Vector4 object from v of another precision.
+  template <typename T>
+  __host__ __device__
+  explicit Vector4(const Vector4<T>& v)
+  {
+    set(real(v.x), real(v.y), real(v.z), real(v.w));
+  }
+
   /// Sets this object to v.
   __host__ __device__
   void set(const vec4& v)
@@ -0,0 +1,57 @@
+#ifndef __MeshOptimizer_h
+#define __MeshOptimizer_h
+
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: MeshOptimizer.h
+//  ========
+//  Class definition for mesh optimizer.
+
+#include "TriangleMesh.h"
+
+namespace Graphics
+{ // begin namespace Graphics
+
+#define DFL_VERTEX_CACHE_SIZE 16
+
+
+//////////////////////////////////////////////////////////
+//
+// MeshOptimizer: mesh optimizer class
+// =============
+class MeshOptimizer
+{
+public:
+  struct Statistics
+  {
+    REAL acmrBefore;
+    REAL acmrAfter;
+
+  }; // Statistics
+
+  // Average cache miss ratio (transformed vertices per triangle)
+  // of a FIFO post-transform vertex cache
+  static REAL ACMR(const TriangleMesh::Arrays&, int = DFL_VERTEX_CACHE_SIZE);
+
+  // Reorder the triangles for the post-transform vertex cache
+  static void optimizeVertexCache(TriangleMesh::Arrays&);
+
+  // Reorder the vertices by first use and remap the triangles
+  static void optimizeVertexFetch(TriangleMesh::Arrays&);
+
+  // Optimize the vertex cache and then the vertex fetch
+  static Statistics execute(TriangleMesh::Arrays&);
+
+}; // MeshOptimizer
+
+} // end namespace Graphics
+
+#endif // __MeshOptimizer_h
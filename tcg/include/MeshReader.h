@@ -28,6 +28,7 @@ namespace Graphics
 class MeshReader
 {
 public:
+  // Read a Wavefront OBJ file (0 on failure)
   TriangleMesh* execute(const char*);
 
 }; // MeshReader
@@ -0,0 +1,58 @@
+#ifndef __MeshSimplifier_h
+#define __MeshSimplifier_h
+
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: MeshSimplifier.h
+//  ========
+//  Class definition for mesh simplifier.
+
+#include "TriangleMesh.h"
+
+namespace Graphics
+{ // begin namespace Graphics
+
+
+//////////////////////////////////////////////////////////
+//
+// MeshSimplifier: quadric error mesh simplifier class
+// ==============
+//
+// Edge-collapse simplification driven by quadric error metrics
+// (Garland and Heckbert). The error of a simplified mesh is the
+// square root of the largest quadric error among the collapses
+// performed, i.e., an estimate of the largest distance between the
+// simplified mesh and the planes of the original triangles.
+// Boundary edges are kept in place by heavily weighted constraint
+// quadrics, which steer the collapses but are not part of the error.
+//
+class MeshSimplifier
+{
+public:
+  // Simplify a mesh down to (at most) a number of triangles;
+  // return null if the simplified mesh cannot be allocated
+  static TriangleMesh* execute(const TriangleMesh&, int, REAL* = 0);
+
+  // Make a chain of LODs given by a sequence of decreasing
+  // triangle ratios; each LOD is simplified from the previous one
+  // and its error accumulates the errors of the previous LODs.
+  // Return the number of LODs made
+  static int makeLODs(const TriangleMesh&,
+    const REAL[],
+    int,
+    TriangleMesh*[],
+    REAL[]);
+
+}; // MeshSimplifier
+
+} // end namespace Graphics
+
+#endif // __MeshSimplifier_h
@@ -26,6 +26,9 @@ namespace Graphics
 //
 // MeshSweeper: mesh sweeper class
 // ===========
+//
+// The make functions return null if the mesh cannot be allocated.
+//
 class MeshSweeper: public Sweeper
 {
 public:
@@ -15,6 +15,7 @@
 //  ========
 //  Class definition for generic model.
 
+#include "Array.h"
 #include "Geometry/Bounds3.h"
 #include "Material.h"
 
@@ -24,6 +25,8 @@ using namespace Geometry;
 namespace Graphics
 { // begin namespace Graphics
 
+class Actor;
+class ChunkedMesh;
 class TriangleMesh;
 
 
@@ -43,21 +46,83 @@ public:
   virtual const Material* getMaterial() const = 0;
   virtual Bounds3 boundingBox() const = 0;
   virtual const TriangleMesh* triangleMesh() const = 0;
+  virtual ChunkedMesh* chunkedMesh() const
+  {
+    return 0;
+  }
+
+  // LOD 0 is the full resolution mesh; the error of a LOD is
+  // relative to the diagonal of the model bounding box
+  virtual int getNumberOfLODs() const
+  {
+    return 1;
+  }
+
+  virtual const TriangleMesh* lodMesh(int) const
+  {
+    return triangleMesh();
+  }
+
+  virtual REAL lodError(int) const
+  {
+    return 0;
+  }
+
+  // The timestamp is incremented whenever the matrix or material
+  // of the model is set
+  uint getTimestamp() const
+  {
+    return timestamp;
+  }
+
   virtual mat4 getMatrix() const = 0;
+  virtual mat4 getInverseMatrix() const = 0;
+  // Inverse transposed of the 3x3 part of the matrix
+  virtual mat3 getNormalMatrix() const = 0;
 
   virtual void setMaterial(Material*) = 0;
   virtual void setMatrix(const mat4&) = 0;
+  // Set the matrix and its (known) inverse
+  virtual void setMatrix(const mat4&, const mat4&) = 0;
 
   void setTRS(const vec3& p, const quat& q, const vec3& s)
   {
-    setMatrix(mat4::TRS(p, q, s));
+    setMatrix(mat4::TRS(p, q, s), mat4::inverseTRS(p, q, s));
   }
 
   void setTRS(const vec3& p, const vec3& a, const vec3& s)
   {
-    setMatrix(mat4::TRS(p, a, s));
+    setMatrix(mat4::TRS(p, a, s), mat4::inverseTRS(p, a, s));
   }
 
+protected:
+  uint timestamp;
+  Array<Actor*> actors; // actors of this model
+
+  // Protected constructors
+  Model():
+    timestamp(0)
+  {
+    // do nothing
+  }
+
+  // The copy has no actors yet
+  Model(const Model& model):
+    Object(model),
+    timestamp(model.timestamp)
+  {
+    // do nothing
+  }
+
+  // Increment the timestamp and queue the rows of the actors of
+  // this model to be refreshed
+  void modified();
+
+private:
+  Model& operator =(const Model&);
+
+  friend class Actor;
+
 }; // Model
 
 
@@ -78,29 +143,64 @@ public:
     return matrix;
   }
 
+  mat4 getInverseMatrix() const
+  {
+    return inverseMatrix;
+  }
+
+  mat3 getNormalMatrix() const
+  {
+    return normalMatrix;
+  }
+
+  // The inverse and normal matrices are computed here, rather than
+  // every time they are used. A singular matrix gets the identity
+  // as its inverse
   void setMatrix(const mat4& m)
   {
     matrix = m;
+    if (!(m.isAffine() ? m.inverseAffine(inverseMatrix) :
+      m.inverse(inverseMatrix)))
+      inverseMatrix = mat4::identity();
+    normalMatrix = mat3(inverseMatrix).transposed();
+    modified();
+  }
+
+  void setMatrix(const mat4& m, const mat4& inverse)
+  {
+    matrix = m;
+    inverseMatrix = inverse;
+    normalMatrix = mat3(inverseMatrix).transposed();
+    modified();
   }
 
   void setMaterial(Material* m)
   {
     material = m == 0 ? Material::getDefault() : m;
+    modified();
   }
 
 protected:
   mat4 matrix;
+  mat4 inverseMatrix;
+  mat3 normalMatrix;
   ObjectPtr<Material> material;
 
   // Protected constructors
   Primitive():
     matrix(mat4::identity()),
+    inverseMatrix(mat4::identity()),
+    normalMatrix(mat3::identity()),
     material(Material::getDefault())
   {
     // do nothing
   }
 
   Primitive(const Primitive& primitive):
+    Model(primitive),
+    matrix(primitive.matrix),
+    inverseMatrix(primitive.inverseMatrix),
+    normalMatrix(primitive.normalMatrix),
     material(primitive.material)
   {
     // do nothing
@@ -15,6 +15,9 @@
 //  ========
 //  Class definition for generic object.
 
+#include <atomic>
+#include <utility>
+
 namespace System
 { // begin namespace System
 
@@ -23,6 +26,13 @@ namespace System
 //
 // Object: generic object class
 // ======
+//
+// The reference counter is atomic, so that objects can be shared
+// among threads. A use is taken with a relaxed increment, since a
+// thread can only make use of an object it already references;
+// a release is an acquire-release decrement, so that all the uses
+// of the object happen before its deletion.
+//
 class Object
 {
 public:
@@ -41,7 +51,7 @@ public:
   // Get number of uses of this object
   int getNumberOfUses() const
   {
-    return counter;
+    return counter.load(std::memory_order_relaxed);
   }
 
   template <typename T> friend T* makeUse(T*);
@@ -49,7 +59,7 @@ public:
   // Release this object
   void release()
   {
-    if (--counter <= 0)
+    if (counter.fetch_sub(1, std::memory_order_acq_rel) <= 1)
       delete this;
   }
 
@@ -61,8 +71,21 @@ protected:
     // do nothing
   }
 
+  // Protected copy constructor (the copy has no uses yet)
+  Object(const Object&):
+    counter(0)
+  {
+    // do nothing
+  }
+
+  Object& operator =(const Object&)
+  {
+    // the number of uses is not copied
+    return *this;
+  }
+
 private:
-  int counter; // reference counter
+  std::atomic<int> counter; // reference counter
 
 }; // Object
 
@@ -71,7 +94,7 @@ inline T*
 makeUse(T* object)
 {
   if (object != 0)
-    ++object->counter;
+    object->counter.fetch_add(1, std::memory_order_relaxed);
   return object;
 }
 
@@ -88,6 +111,10 @@ release(T* object)
 //
 // ObjectPtr: object pointer class
 // =========
+//
+// Moving an object pointer transfers its use of the object, without
+// touching the reference counter.
+//
 template <typename T>
 class ObjectPtr
 {
@@ -104,6 +131,12 @@ public:
     this->object = makeUse(ptr.object);
   }
 
+  ObjectPtr(ObjectPtr<T>&& ptr):
+    object(ptr.object)
+  {
+    ptr.object = 0;
+  }
+
   ObjectPtr(T* object)
   {
     this->object = makeUse(object);
@@ -115,17 +148,25 @@ public:
     release(this->object);
   }
 
+  // The new object is used before the old one is released, since
+  // both can be the same object
   ObjectPtr<T>& operator =(T* object)
   {
-    release(this->object);
+    T* old = this->object;
+
     this->object = makeUse(object);
+    release(old);
     return *this;
   }
 
   ObjectPtr<T>& operator =(const ObjectPtr<T>& ptr)
   {
-    release(this->object);
-    this->object = makeUse(ptr.object);
+    return operator =(ptr.object);
+  }
+
+  ObjectPtr<T>& operator =(ObjectPtr<T>&& ptr)
+  {
+    std::swap(this->object, ptr.object);
     return *this;
   }
 
@@ -0,0 +1,132 @@
+#ifndef __OcclusionCuller_h
+#define __OcclusionCuller_h
+
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: OcclusionCuller.h
+//  ========
+//  Class definition for HiZ occlusion culler.
+
+#include "Array.h"
+#include "TriangleMesh.h"
+
+using namespace System::Collections;
+
+namespace Graphics
+{ // begin namespace Graphics
+
+#define DFL_OCCLUSION_WIDTH  256
+#define DFL_OCCLUSION_HEIGHT 128
+#define MAX_OCCLUSION_LEVELS 16
+
+
+//////////////////////////////////////////////////////////
+//
+// OcclusionCuller: HiZ occlusion culler class
+// ===============
+//
+// A few large occluders are rasterized on the CPU into a low
+// resolution depth buffer, from which a hierarchical Z pyramid
+// is built; each texel of a level keeps the farthest depth of
+// the four texels below it. A box is occluded if its nearest
+// depth is behind the farthest depth of the texels covering its
+// screen rectangle.
+//
+// Depths are in [0, 1]. Occluder triangles crossing the near plane
+// are skipped and boxes crossing it are never occluded. Coverage is
+// sampled at texel centers (inner conservative coverage would open
+// cracks along the shared edges of the occluder triangles), so an
+// object seen through less than a texel of the buffer may be culled.
+//
+class OcclusionCuller
+{
+public:
+  // Constructor
+  OcclusionCuller(int = DFL_OCCLUSION_WIDTH, int = DFL_OCCLUSION_HEIGHT);
+
+  // Destructor
+  ~OcclusionCuller();
+
+  int getWidth() const
+  {
+    return widths[0];
+  }
+
+  int getHeight() const
+  {
+    return heights[0];
+  }
+
+  int getNumberOfLevels() const
+  {
+    return numberOfLevels;
+  }
+
+  int getNumberOfTriangles() const
+  {
+    return triangles.size();
+  }
+
+  // Return the depth of a texel of a level (0 is the depth buffer)
+  float getDepth(int x, int y, int level = 0) const
+  {
+    return levels[level][y * strides[level] + x];
+  }
+
+  void setSize(int, int);
+
+  // Clear the depth buffer and the occluders of the last frame
+  void begin(const mat4&);
+  // Add the triangles of a mesh, transformed by a matrix, as occluders
+  void addOccluder(const TriangleMesh&, const mat4&);
+  // Rasterize the occluders and build the HiZ pyramid
+  void end();
+
+  // Return true if a (world) box is hidden by the occluders
+  bool isOccluded(const Bounds3&) const;
+
+private:
+  struct Vertex
+  {
+    float x, y, z; // screen coordinates and depth
+    bool clipped; // behind the near plane
+
+  }; // Vertex
+
+  struct Triangle
+  {
+    Vertex v[3];
+    int yMin, yMax; // rows covered
+
+  }; // Triangle
+
+  mat4 vpMatrix;
+  float* levels[MAX_OCCLUSION_LEVELS];
+  int widths[MAX_OCCLUSION_LEVELS];
+  int heights[MAX_OCCLUSION_LEVELS];
+  int strides[MAX_OCCLUSION_LEVELS];
+  int numberOfLevels;
+  Array<Vertex> vertices;
+  Array<Triangle> triangles;
+
+  static Vertex project(const mat4&, const vec3&, int, int);
+  void rasterize(const Triangle&, int, int);
+  void buildPyramid();
+  void freeLevels();
+
+  OcclusionCuller(const OcclusionCuller&);
+  OcclusionCuller& operator =(const OcclusionCuller&);
+
+}; // OcclusionCuller
+
+} // end namespace Graphics
+
+#endif // __OcclusionCuller_h
@@ -15,7 +15,7 @@
 //  ========
 //  Class definition for scene.
 
-#include "Actor.h"
+#include "ActorTable.h"
 #include "Light.h"
 
 namespace Graphics
@@ -41,7 +41,7 @@ public:
     ambientLight(Color::gray),
     IOR(1)
   {
-    modifiedBounds = false;
+    // do nothing
   }
 
   // Destructor
@@ -67,6 +67,11 @@ public:
     return ActorIterator(actors);
   }
 
+  const ActorTable& getActorTable() const
+  {
+    return actorTable;
+  }
+
   int getNumberOfLights() const
   {
     return lights.size();
@@ -78,8 +83,13 @@ public:
   }
 
   Actor* findActor(Model*) const;
+  // Find the actor whose bounds, as of the last update(), are hit
+  // first by a ray
+  Actor* pickActor(const Ray&, REAL&) const;
 
   void addActor(Actor*);
+  // Queue the row of an actor to be refreshed by the next update()
+  void updateActor(Actor*);
   void deleteActor(Actor*);
   void deleteActors();
   void addLight(Light*);
@@ -92,17 +102,21 @@ public:
     deleteLights();
   }
 
-  const Bounds3& boundingBox();
+  const Bounds3& boundingBox() const
+  {
+    return actorTable.boundingBox();
+  }
+
+  // Refresh the actor table (once per frame); return the number
+  // of actors refreshed
+  int update();
 
 protected:
-  bool modifiedBounds;
-  Bounds3 bounds;
   REAL IOR;
   // Scene components
   Actors actors;
   Lights lights;
-
-  void updateBounds();
+  ActorTable actorTable;
 
 }; // Scene
 
@@ -18,7 +18,6 @@
 #include "Core/Flags.h"
 #include "DsMath"
 #include "Array.h"
-#include "List.h"
 #include "Object.h"
 
 using namespace Ds;
@@ -28,6 +27,8 @@ using namespace System::Collections;
 namespace Graphics
 { // begin namespace Graphics
 
+#define DFL_POLYLINE_SIZE 32
+
 
 //////////////////////////////////////////////////////////
 //
@@ -73,8 +74,10 @@ public:
 
     }; // Sweeper::Polyline::Vertex
 
-    typedef List<Vertex> Vertices;
-    typedef ListIterator<Vertex> VertexIterator;
+    // The vertices are contiguous and the first DFL_POLYLINE_SIZE
+    // ones are stored in the polyline data itself
+    typedef SmallArray<Vertex, DFL_POLYLINE_SIZE> Vertices;
+    typedef SmallArrayIterator<Vertex, DFL_POLYLINE_SIZE> VertexIterator;
 
     // Constructors
     Polyline():
@@ -83,11 +86,41 @@ public:
       // do nothing
     }
 
+    Polyline(const Polyline& polyline):
+      data(polyline.data)
+    {
+      // do nothing
+    }
+
+    Polyline(Polyline&& polyline):
+      data(std::move(polyline.data))
+    {
+      // do nothing
+    }
+
+    Polyline& operator =(const Polyline& polyline)
+    {
+      data = polyline.data;
+      return *this;
+    }
+
+    Polyline& operator =(Polyline&& polyline)
+    {
+      data = std::move(polyline.data);
+      return *this;
+    }
+
     void mv(const vec3& position)
     {
       data->vertices.add(Vertex(position));
     }
 
+    // Make room for (at least) a number of vertices
+    void reserve(int n)
+    {
+      data->vertices.reserve(n);
+    }
+
     void transform(const mat4&);
 
     void open()
@@ -105,6 +138,11 @@ public:
       return data->vertices.size();
     }
 
+    const Vertex* getVertices() const
+    {
+      return data->vertices.getData();
+    }
+
     VertexIterator getVertexIterator() const
     {
       return VertexIterator(data->vertices);
@@ -27,6 +27,11 @@ namespace Graphics
 
 using namespace System;
 
+#define MAX_MESHLET_VERTICES  64
+#define MAX_MESHLET_TRIANGLES 124
+#define MESH_BLOCK_ALIGNMENT  64
+#define VERTEX_STREAM_PADDING 16
+
 //
 // Auxiliary functions
 //
@@ -152,6 +157,44 @@ private:
 }; // Triangle
 
 
+//////////////////////////////////////////////////////////
+//
+// ArrayBuffer: reference-counted array class
+// ===========
+template <typename T>
+class ArrayBuffer: public Object
+{
+public:
+  T* const data;
+
+  // Constructors
+  ArrayBuffer(T* aData):
+    data(aData)
+  {
+    // do nothing
+  }
+
+  // The array lives in a memory block owned by someone else
+  ArrayBuffer(T* aData, Object* aBlock):
+    data(aData),
+    block(aBlock)
+  {
+    // do nothing
+  }
+
+  // Destructor
+  ~ArrayBuffer()
+  {
+    if (block == 0)
+      delete []data;
+  }
+
+private:
+  ObjectPtr<Object> block;
+
+}; // ArrayBuffer
+
+
 //////////////////////////////////////////////////////////
 //
 // TriangleMesh: simple triangle mesh class
@@ -219,32 +262,306 @@ public:
 
   }; // Arrays
 
-  ObjectPtr<Object> userData;
+  // Vertex-triangle adjacency (CSR format). The corners incident to
+  // the vertex v are corners[offsets[v]..offsets[v + 1] - 1]; each
+  // corner is 3 * t + k, where t is a triangle and k in {0, 1, 2}.
+  struct VertexTriangles
+  {
+    int* offsets;
+    int* corners;
 
-  // Constructor
-  TriangleMesh(const Arrays& aData):
-    data(aData)
+    // Constructor
+    VertexTriangles(const Arrays&);
+
+    // Destructor
+    ~VertexTriangles()
+    {
+      delete []offsets;
+      delete []corners;
+    }
+
+    int begin(int v) const
+    {
+      return offsets[v];
+    }
+
+    int end(int v) const
+    {
+      return offsets[v + 1];
+    }
+
+  private:
+    VertexTriangles(const VertexTriangles&);
+    VertexTriangles& operator =(const VertexTriangles&);
+
+  }; // VertexTriangles
+
+  // Index-based half-edge structure. The half-edge 3 * t + k goes
+  // from the corner k to the corner (k + 1) % 3 of the triangle t;
+  // twins[h] is the opposite half-edge of h, or Boundary if h is on
+  // a boundary, or NonManifold if h is shared by more than two
+  // triangles (or by two inconsistently oriented ones).
+  struct HalfEdges: public Object
   {
-    // do nothing
-  }
+    enum
+    {
+      Boundary = -1,
+      NonManifold = -2
+    };
+
+    int* twins;
+    // An outgoing half-edge of each vertex (or -1); for boundary
+    // vertices, the first one in counterclockwise order
+    int* vertexEdges;
+    int numberOfHalfEdges;
+    int numberOfVertices;
+    int numberOfBoundaryEdges;
+    int numberOfNonManifoldEdges;
+    int numberOfNonManifoldVertices;
 
-  // Destructor
-  ~TriangleMesh()
+    // Constructor
+    HalfEdges(const Arrays&);
+
+    // Destructor
+    ~HalfEdges()
+    {
+      delete []twins;
+      delete []vertexEdges;
+      delete []vertexFlags;
+    }
+
+    static int face(int h)
+    {
+      return h / 3;
+    }
+
+    static int next(int h)
+    {
+      return h % 3 == 2 ? h - 2 : h + 1;
+    }
+
+    static int prev(int h)
+    {
+      return h % 3 == 0 ? h + 2 : h - 1;
+    }
+
+    int twin(int h) const
+    {
+      return twins[h];
+    }
+
+    int origin(int h) const
+    {
+      return triangles[h / 3].v[h % 3];
+    }
+
+    int target(int h) const
+    {
+      return origin(next(h));
+    }
+
+    bool isBoundary(int h) const
+    {
+      return twins[h] == Boundary;
+    }
+
+    bool isBoundaryVertex(int v) const
+    {
+      return (vertexFlags[v] & BoundaryVertex) != 0;
+    }
+
+    bool isManifoldVertex(int v) const
+    {
+      return (vertexFlags[v] & NonManifoldVertex) == 0;
+    }
+
+    bool isManifold() const
+    {
+      return numberOfNonManifoldEdges + numberOfNonManifoldVertices == 0;
+    }
+
+    bool isClosed() const
+    {
+      return numberOfBoundaryEdges == 0;
+    }
+
+    // Fill the vertices adjacent to a vertex in counterclockwise
+    // order and return their number (only the first fan of a
+    // non-manifold vertex is visited)
+    int oneRing(int, int*, int) const;
+
+  private:
+    enum
+    {
+      BoundaryVertex = 1,
+      NonManifoldVertex = 2
+    };
+
+    const Triangle* triangles;
+    unsigned char* vertexFlags;
+
+    HalfEdges(const HalfEdges&);
+    HalfEdges& operator =(const HalfEdges&);
+
+  }; // HalfEdges
+
+  // Cluster of adjacent triangles of a mesh. The triangles of a
+  // meshlet are contiguous in the triangle array of the mesh.
+  struct Meshlet
   {
-    delete data.vertices;
-    delete data.normals;
-    delete data.triangles;
-    delete data.colors;
-  }
+    int firstTriangle;
+    int numberOfTriangles;
+    int firstVertex; // index into Meshlets::vertices
+    int numberOfVertices;
+    Bounds3 bounds;
+    vec3 center; // bounding sphere
+    REAL radius;
+    vec3 coneApex; // normal cone
+    vec3 coneAxis;
+    REAL coneCutoff; // greater than 1 if the cone is not usable
+
+    // Is the meshlet back-facing from a (mesh space) viewpoint?
+    bool isBackfacing(const vec3& eye) const
+    {
+      return (coneApex - eye).versor().dot(coneAxis) >= coneCutoff;
+    }
+
+    // Is the meshlet outside the clipping volume of a matrix
+    // (e.g., the model-view-projection matrix)?
+    bool isOutside(const mat4&) const;
+
+  }; // Meshlet
+
+  struct Meshlets: public Object
+  {
+    Meshlet* meshlets;
+    int numberOfMeshlets;
+    // Mesh vertex indices of the vertices of each meshlet
+    int* vertices;
+    // Meshlet vertex indices of the corners of each mesh triangle
+    unsigned char* indices;
+
+    // Constructor (the triangles are reordered by meshlet)
+    Meshlets(Arrays&, int, int);
+
+    // Destructor
+    ~Meshlets()
+    {
+      delete []meshlets;
+      delete []vertices;
+      delete []indices;
+    }
+
+  private:
+    Meshlets(const Meshlets&);
+    Meshlets& operator =(const Meshlets&);
+
+  }; // Meshlets
+
+  // Single memory block holding the arrays of a mesh. The block
+  // starts with a header of array offsets and every array is
+  // aligned to MESH_BLOCK_ALIGNMENT bytes, so a block can be
+  // written to and read from a file as a whole.
+  class Block: public Object
+  {
+  public:
+    // Destructor
+    ~Block();
+
+    // Make a block for the given numbers of vertices, normals,
+    // triangles and colors
+    static Block* New(int, int, int, int);
+    // Read a block from a file (0 on failure)
+    static Block* read(FILE*);
+
+    bool write(FILE*) const;
+
+    // Arrays pointing into the block
+    Arrays getArrays() const;
+    int64 getSize() const;
+
+  private:
+    struct Header;
+
+    Header* header;
+
+    // Private constructor
+    Block(Header*);
+
+  }; // Block
+
+  // Structure-of-arrays copy of the vertex positions, in a single
+  // aligned block. Each stream is padded to a multiple of
+  // VERTEX_STREAM_PADDING with copies of the last vertex, so that
+  // SIMD loops need no remainder handling.
+  struct VertexStreams: public Object
+  {
+    REAL* x;
+    REAL* y;
+    REAL* z;
+    int numberOfVertices;
+    int size; // padded size of each stream
+
+    // Constructor
+    VertexStreams(const Arrays&);
+
+    // Destructor
+    ~VertexStreams();
+
+  private:
+    VertexStreams(const VertexStreams&);
+    VertexStreams& operator =(const VertexStreams&);
+
+  }; // VertexStreams
+
+  enum NormalWeighting
+  {
+    UniformWeighting,
+    AreaWeighting,
+    AngleWeighting
+  };
+
+  ObjectPtr<Object> userData;
+
+  // Constructors (the mesh takes ownership of the arrays)
+  TriangleMesh(const Arrays&);
+  TriangleMesh(Block*);
 
   Object* clone() const;
   Bounds3 boundingBox() const;
 
-  void computeNormals();
+  void computeNormals(NormalWeighting = UniformWeighting, REAL = 180);
+
+  // Transform the vertices and normals by an affine matrix
+  void transform(const mat4&);
+
+  // Split the mesh into meshlets
+  void buildMeshlets(int = MAX_MESHLET_VERTICES, int = MAX_MESHLET_TRIANGLES);
+
+  const Meshlets* getMeshlets() const
+  {
+    return meshlets;
+  }
+
+  // Half-edges of the mesh (built on the first call and kept until
+  // the triangles are edited)
+  const HalfEdges& getHalfEdges() const;
+
+  // The vertices are kept as an array of vec3 (AoS); the streams
+  // (SoA) are built on the first call and kept until the vertices
+  // are edited. Loops over all vertices, such as boundingBox(), use
+  // the streams if they exist; gathers through the triangles, such
+  // as computeNormals(), and the GL vertex arrays use the vec3s.
+  const VertexStreams& getVertexStreams() const;
+
+  bool hasVertexStreams() const
+  {
+    return streams != 0;
+  }
 
   void setColors(Color* colors, int n)
   {
-    delete data.colors;
+    colorBuffer = colors != 0 ? new ArrayBuffer<Color>(colors) : 0;
     data.colors = colors;
     data.numberOfColors = n;
   }
@@ -254,8 +571,29 @@ public:
     return data;
   }
 
+  // Copy-on-write access to the arrays. The arrays of a mesh are
+  // shared with its clones until either one asks for writing;
+  // whatever depends on the array is invalidated
+  vec3* editVertices();
+  vec3* editNormals();
+  Triangle* editTriangles();
+  Color* editColors();
+
 protected:
   Arrays data;
+  ObjectPtr<ArrayBuffer<vec3> > vertexBuffer;
+  ObjectPtr<ArrayBuffer<vec3> > normalBuffer;
+  ObjectPtr<ArrayBuffer<Triangle> > triangleBuffer;
+  ObjectPtr<ArrayBuffer<Color> > colorBuffer;
+  ObjectPtr<Meshlets> meshlets;
+  mutable ObjectPtr<HalfEdges> halfEdges;
+  mutable ObjectPtr<VertexStreams> streams;
+
+  // Protected copy constructor (the arrays are shared)
+  TriangleMesh(const TriangleMesh&);
+
+private:
+  TriangleMesh& operator =(const TriangleMesh&);
 
 }; // TriangleMesh
 
@@ -21,6 +21,8 @@
 namespace Graphics
 { // begin namespace Graphics
 
+#define MAX_LODS 4
+
 
 //////////////////////////////////////////////////////////
 //
@@ -31,7 +33,8 @@ class TriangleMeshShape: public Primitive
 public:
   // Constructor
   TriangleMeshShape(TriangleMesh* aMesh):
-    mesh(aMesh)
+    mesh(aMesh),
+    numberOfLODs(0)
   {
     if (aMesh != 0)
       bounds = aMesh->boundingBox();
@@ -41,9 +44,27 @@ public:
   Bounds3 boundingBox() const;
   const TriangleMesh* triangleMesh() const;
 
+  int getNumberOfLODs() const
+  {
+    return numberOfLODs + 1;
+  }
+
+  const TriangleMesh* lodMesh(int) const;
+  REAL lodError(int) const;
+
+  // Add a LOD given its (object space) error
+  bool addLOD(TriangleMesh*, REAL);
+  // Make LODs by simplifying the mesh
+  int makeLODs(const REAL[], int);
+
 private:
   ObjectPtr<TriangleMesh> mesh;
   Bounds3 bounds;
+  ObjectPtr<TriangleMesh> lods[MAX_LODS];
+  REAL lodErrors[MAX_LODS];
+  int numberOfLODs;
+
+  TriangleMeshShape(const TriangleMeshShape&);
 
 }; // TriangleMeshShape
 
@@ -0,0 +1,591 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: ActorTable.cpp
+//  ========
+//  Source file for packed actor table.
+
+#include "ActorTable.h"
+
+using namespace Graphics;
+
+// Levels with fewer rows are transformed sequentially
+#define MIN_PARALLEL_LEVEL 1024
+
+
+//////////////////////////////////////////////////////////
+//
+// ActorTable implementation
+// ==========
+void
+ActorTable::add(Actor* actor)
+//[]---------------------------------------------------[]
+//|  Add                                                |
+//[]---------------------------------------------------[]
+{
+  Node node;
+
+  // The transform of the row is set by update(i) below
+  node.matrix = mat4::identity();
+  node.normalMatrix = mat3::identity();
+  node.parent = -1;
+  actor->index = actors.size();
+  actors.add(actor);
+  flags.add(Flags());
+  nodes.add(node);
+  matrices.add(mat4::identity());
+  normalMatrices.add(mat3::identity());
+  bounds.add(Bounds3());
+  proxies.add(-1);
+  meshes.add(0);
+  materialIds.add(0);
+  queued.add(false);
+  dirty.add(false);
+  modifiedHierarchy = true;
+  update(actor->index);
+}
+
+void
+ActorTable::remove(Actor* actor)
+//[]---------------------------------------------------[]
+//|  Remove                                             |
+//|                                                     |
+//|  The row of the actor is filled with the last row.  |
+//|  The children of the actor become roots.            |
+//[]---------------------------------------------------[]
+{
+  int i = actor->index;
+  int last = actors.size() - 1;
+
+  tree.remove(proxies[i]);
+  if (flags[i].isSet(Actor::Dynamic) || flags[last].isSet(Actor::Dynamic))
+    modifiedDynamics = true;
+  if (i != last)
+  {
+    // The entries of the last row in the queue and in the dirty
+    // rows are dropped by update()
+    if (queued[last])
+      modifiedRows.add(i);
+    if (dirty[last])
+      dirtyRows.add(i);
+    (actors[i] = actors[last])->index = i;
+    flags[i] = flags[last];
+    nodes[i] = nodes[last];
+    matrices[i] = matrices[last];
+    normalMatrices[i] = normalMatrices[last];
+    bounds.set(i, bounds[last]);
+    tree.setData(proxies[i] = proxies[last], i);
+    meshes[i] = meshes[last];
+    materialIds[i] = materialIds[last];
+    queued[i] = queued[last];
+    dirty[i] = dirty[last];
+  }
+  actors.removeAt(last);
+  flags.removeAt(last);
+  nodes.removeAt(last);
+  matrices.removeAt(last);
+  normalMatrices.removeAt(last);
+  bounds.removeLast();
+  proxies.removeAt(last);
+  meshes.removeAt(last);
+  materialIds.removeAt(last);
+  queued.removeAt(last);
+  dirty.removeAt(last);
+  actor->index = -1;
+  modifiedHierarchy = true;
+}
+
+void
+ActorTable::clear()
+//[]---------------------------------------------------[]
+//|  Clear                                              |
+//[]---------------------------------------------------[]
+{
+  for (int i = 0, n = actors.size(); i < n; i++)
+    actors[i]->index = -1;
+  actors.clear();
+  flags.clear();
+  nodes.clear();
+  matrices.clear();
+  normalMatrices.clear();
+  bounds.clear();
+  proxies.clear();
+  tree.clear();
+  meshes.clear();
+  materialIds.clear();
+  queued.clear();
+  modifiedRows.clear();
+  dynamicRows.clear();
+  dirty.clear();
+  dirtyRows.clear();
+  materials.clear();
+  depths.clear();
+  children.clear();
+  firstChild.clear();
+  height = 0;
+  modifiedHierarchy = modifiedDynamics = false;
+}
+
+int
+ActorTable::materialId(const Material* material)
+//[]---------------------------------------------------[]
+//|  Material ID                                        |
+//[]---------------------------------------------------[]
+{
+  int n = materials.size();
+
+  for (int id = 0; id < n; id++)
+    if (materials[id] == material)
+      return id;
+  materials.add((Material*)material);
+  return n;
+}
+
+int
+ActorTable::parentRow(int i) const
+//[]---------------------------------------------------[]
+//|  Parent row                                         |
+//|                                                     |
+//|  A parent which is not in the scene of the actor    |
+//|  is ignored.                                        |
+//[]---------------------------------------------------[]
+{
+  const Actor* actor = actors[i];
+  const Actor* parent = actor->parent;
+
+  if (parent == 0 || parent->getScene() != actor->getScene())
+    return -1;
+  return parent->index;
+}
+
+inline void
+ActorTable::setDirty(int i)
+//[]---------------------------------------------------[]
+//|  Set dirty                                          |
+//[]---------------------------------------------------[]
+{
+  if (!dirty[i])
+  {
+    dirty[i] = true;
+    dirtyRows.add(i);
+  }
+}
+
+inline void
+ActorTable::transform(int i, int p)
+//[]---------------------------------------------------[]
+//|  Transform                                          |
+//|                                                     |
+//|  Compute the world transform of the row i given its |
+//|  parent row p. The box of i in the bounds tree must |
+//|  be invalidated by the caller.                      |
+//[]---------------------------------------------------[]
+{
+  const Node& node = nodes[i];
+  Bounds3& box = bounds.getBoxes()[i];
+
+  if (p < 0)
+  {
+    matrices[i] = node.matrix;
+    normalMatrices[i] = node.normalMatrix;
+    box = node.bounds;
+  }
+  else
+  {
+    // The normal matrix of a product is the product of the
+    // normal matrices
+    matrices[i] = matrices[p] * node.matrix;
+    normalMatrices[i] = normalMatrices[p] * node.normalMatrix;
+    box = Bounds3(node.bounds, matrices[p]);
+  }
+}
+
+void
+ActorTable::update(int i)
+//[]---------------------------------------------------[]
+//|  Update row                                         |
+//[]---------------------------------------------------[]
+{
+  const Actor* actor = actors[i];
+  const Model* model = actor->getModel();
+  Node& node = nodes[i];
+  int p = parentRow(i);
+
+  if (flags[i].isSet(Actor::Dynamic) != actor->flags.isSet(Actor::Dynamic))
+    modifiedDynamics = true;
+  flags[i] = actor->flags;
+  node.matrix = model->getMatrix();
+  node.normalMatrix = model->getNormalMatrix();
+  node.bounds = model->boundingBox();
+  meshes[i] = model->triangleMesh();
+  materialIds[i] = materialId(model->getMaterial());
+  queued[i] = false;
+  if (p != node.parent)
+    modifiedHierarchy = true;
+  // The world transform is computed right away, but the row is
+  // dirty until its descendants are updated
+  transform(i, p);
+  bounds.invalidate(i);
+  updateProxy(i);
+  setDirty(i);
+}
+
+void
+ActorTable::invalidate(int i)
+//[]---------------------------------------------------[]
+//|  Invalidate row                                     |
+//[]---------------------------------------------------[]
+{
+  if (!queued[i])
+  {
+    queued[i] = true;
+    modifiedRows.add(i);
+  }
+}
+
+inline void
+ActorTable::updateProxy(int i)
+//[]---------------------------------------------------[]
+//|  Update proxy                                       |
+//[]---------------------------------------------------[]
+{
+  if (proxies[i] < 0)
+    proxies[i] = tree.insert(bounds[i], i);
+  else
+    tree.move(proxies[i], bounds[i]);
+}
+
+void
+ActorTable::updateDynamics()
+//[]---------------------------------------------------[]
+//|  Update dynamics                                    |
+//|                                                     |
+//|  List the rows of dynamic actors.                   |
+//[]---------------------------------------------------[]
+{
+  dynamicRows.clear();
+  for (int i = 0, n = actors.size(); i < n; i++)
+    if (flags[i].isSet(Actor::Dynamic))
+      dynamicRows.add(i);
+}
+
+void
+ActorTable::updateLevels()
+//[]---------------------------------------------------[]
+//|  Update levels                                      |
+//|                                                     |
+//|  Find the level (the number of ancestors) and the   |
+//|  children of each row.                              |
+//[]---------------------------------------------------[]
+{
+  int n = actors.size();
+
+  depths.clear();
+  depths.reserve(n);
+  for (int i = 0; i < n; i++)
+  {
+    int p = parentRow(i);
+
+    // Rows whose parents changed are dirty
+    if (p != nodes[i].parent)
+    {
+      nodes[i].parent = p;
+      setDirty(i);
+    }
+    depths.add(-1);
+  }
+
+  int* level = depths.getData();
+
+  height = 0;
+  for (int i = 0; i < n; i++)
+  {
+    // Find the nearest ancestor whose level is known and then
+    // set the levels of the rows up to it
+    int d = 0;
+    int p = i;
+
+    for (; p >= 0 && level[p] < 0; p = nodes[p].parent)
+      d++;
+    for (int q = i, l = (p < 0 ? 0 : level[p] + 1) + d - 1; q != p; l--)
+    {
+      level[q] = l;
+      q = nodes[q].parent;
+    }
+    if (level[i] >= height)
+      height = level[i] + 1;
+  }
+  firstChild.clear();
+  firstChild.reserve(n + 1);
+  for (int i = 0; i <= n; i++)
+    firstChild.add(0);
+  for (int i = 0; i < n; i++)
+    if (nodes[i].parent >= 0)
+      firstChild[nodes[i].parent + 1]++;
+  for (int i = 1; i <= n; i++)
+    firstChild[i] += firstChild[i - 1];
+  children.clear();
+  children.reserve(firstChild[n]);
+  for (int k = firstChild[n]; k > 0; k--)
+    children.add(0);
+
+  int* next = new int[n];
+
+  for (int i = 0; i < n; i++)
+    next[i] = firstChild[i];
+  for (int i = 0; i < n; i++)
+    if (nodes[i].parent >= 0)
+      children[next[nodes[i].parent]++] = i;
+  delete []next;
+}
+
+void
+ActorTable::updateTransforms()
+//[]---------------------------------------------------[]
+//|  Update transforms                                  |
+//[]---------------------------------------------------[]
+{
+  if (modifiedHierarchy)
+  {
+    updateLevels();
+    modifiedHierarchy = false;
+  }
+  if (dirtyRows.isEmpty())
+    return;
+
+  const int n = actors.size();
+  bool* d = dirty.getData();
+
+  // The dirty rows may hold removed and repeated rows
+  subtree.clear();
+  for (int k = 0, m = dirtyRows.size(); k < m; k++)
+  {
+    const int i = dirtyRows[k];
+
+    if (i < n && d[i])
+    {
+      d[i] = false;
+      subtree.add(i);
+    }
+  }
+  dirtyRows.clear();
+  for (int k = 0, m = subtree.size(); k < m; k++)
+    d[subtree[k]] = true;
+  // The descendants of a dirty row are dirty
+  for (int k = 0; k < subtree.size(); k++)
+  {
+    const int i = subtree[k];
+
+    for (int c = firstChild[i], e = firstChild[i + 1]; c < e; c++)
+      if (!d[children[c]])
+      {
+        d[children[c]] = true;
+        subtree.add(children[c]);
+      }
+  }
+
+  const int m = subtree.size();
+
+  // Sort the dirty rows by level
+  levels.clear();
+  for (int l = 0; l <= height; l++)
+    levels.add(0);
+  for (int k = 0; k < m; k++)
+    levels[depths[subtree[k]] + 1]++;
+  for (int l = 1; l <= height; l++)
+    levels[l] += levels[l - 1];
+  order.clear();
+  order.reserve(m);
+  for (int k = 0; k < m; k++)
+    order.add(0);
+
+  int* next = new int[height];
+
+  for (int l = 0; l < height; l++)
+    next[l] = levels[l];
+  for (int k = 0; k < m; k++)
+    order[next[depths[subtree[k]]]++] = subtree[k];
+  delete []next;
+
+  const Node* node = nodes.getData();
+  const int* rows = order.getData();
+
+  // The parents of the rows of a level are in the previous levels
+  for (int l = 0; l < height; l++)
+  {
+    const int b = levels[l];
+    const int e = levels[l + 1];
+
+#pragma omp parallel for if (e - b >= MIN_PARALLEL_LEVEL)
+    for (int k = b; k < e; k++)
+    {
+      const int i = rows[k];
+
+      transform(i, node[i].parent);
+    }
+  }
+  for (int k = 0; k < m; k++)
+  {
+    const int i = rows[k];
+
+    bounds.invalidate(i);
+    updateProxy(i);
+    d[i] = false;
+  }
+}
+
+int
+ActorTable::update()
+//[]---------------------------------------------------[]
+//|  Update                                             |
+//[]---------------------------------------------------[]
+{
+  if (modifiedDynamics)
+  {
+    updateDynamics();
+    modifiedDynamics = false;
+  }
+
+  int count = dynamicRows.size();
+
+  // Refreshing a row takes it out of the queue
+  for (int k = 0; k < count; k++)
+    update(dynamicRows[k]);
+  for (int k = 0, m = modifiedRows.size(), n = actors.size(); k < m; k++)
+  {
+    int i = modifiedRows[k];
+
+    // The queue may hold removed rows
+    if (i < n && queued[i])
+    {
+      update(i);
+      count++;
+    }
+  }
+  modifiedRows.clear();
+  updateTransforms();
+  return count;
+}
+
+int
+ActorTable::findRows(const Bounds3& box, Array<int>& rows) const
+//[]---------------------------------------------------[]
+//|  Find rows (box)                                    |
+//[]---------------------------------------------------[]
+{
+  const Bounds3* b = bounds.getBoxes();
+  int count = 0;
+
+  // The boxes of the tree are enlarged, so the world bounds of
+  // the rows are tested again
+  tree.query(box, [&](int i)
+  {
+    if (b[i].intersect(box))
+    {
+      rows.add(i);
+      count++;
+    }
+    return true;
+  });
+  return count;
+}
+
+int
+ActorTable::findRows(const vec3& center, REAL radius, Array<int>& rows) const
+//[]---------------------------------------------------[]
+//|  Find rows (sphere)                                 |
+//[]---------------------------------------------------[]
+{
+  const Bounds3* b = bounds.getBoxes();
+  const REAL r2 = radius * radius;
+  int count = 0;
+
+  tree.query(center, radius, [&](int i)
+  {
+    if (b[i].squaredDistance(center) <= r2)
+    {
+      rows.add(i);
+      count++;
+    }
+    return true;
+  });
+  return count;
+}
+
+int
+ActorTable::findRows(const Frustum& frustum, Array<int>& rows) const
+//[]---------------------------------------------------[]
+//|  Find rows (frustum)                                |
+//[]---------------------------------------------------[]
+{
+  const Bounds3* b = bounds.getBoxes();
+  int count = 0;
+
+  tree.query(frustum, [&](int i)
+  {
+    if (!frustum.isOutside(b[i]))
+    {
+      rows.add(i);
+      count++;
+    }
+    return true;
+  });
+  return count;
+}
+
+int
+ActorTable::findRows(const Ray& ray, Array<int>& rows) const
+//[]---------------------------------------------------[]
+//|  Find rows (ray)                                    |
+//[]---------------------------------------------------[]
+{
+  const Bounds3* b = bounds.getBoxes();
+  int count = 0;
+
+  tree.query(ray, [&](int i)
+  {
+    REAL t;
+
+    if (b[i].intersect(ray, t))
+    {
+      rows.add(i);
+      count++;
+    }
+    return true;
+  });
+  return count;
+}
+
+int
+ActorTable::pick(const Ray& ray, REAL& distance) const
+//[]---------------------------------------------------[]
+//|  Pick                                               |
+//[]---------------------------------------------------[]
+{
+  const Bounds3* b = bounds.getBoxes();
+  Ray r = ray;
+  int row = -1;
+
+  // Each hit shortens the ray, which prunes the farther subtrees
+  tree.query(r, [&](int i)
+  {
+    REAL t;
+
+    if (b[i].intersect(r, t))
+    {
+      r.tMax = t;
+      row = i;
+    }
+    return true;
+  });
+  if (row >= 0)
+    distance = r.tMax;
+  return row;
+}
@@ -13,6 +13,7 @@
 //  Source file for camera.
 
 #include "Camera.h"
+#include "DsMath"
 #include "Exception.h"
 
 using namespace Graphics;
@@ -33,7 +34,7 @@ error(const char* msg)
 // ======
 uint Camera::nextId;
 
-inline string
+string
 Camera::defaultName()
 {
   char name[16];
@@ -466,22 +467,36 @@ uint
 Camera::updateView()
 //[]---------------------------------------------------[]
 //|  Update matrix                                      |
+//|                                                     |
+//|  The matrices are computed in double precision and  |
+//|  then stored as REAL, so that a camera far from the |
+//|  origin does not lose precision in the translation  |
+//|  of the view matrix and in the VP product.          |
 //[]---------------------------------------------------[]
 {
   if (viewModified)
   {
+    mat4d P;
+
     if (projectionType == Parallel)
     {
-      REAL h = height * REAL(0.5);
-      REAL w = h * aspectRatio;
+      double h = height * 0.5;
+      double w = h * aspectRatio;
 
-      projectionMatrix = mat4::ortho(-w, w, -h, h, -B, B);
+      P = mat4d::ortho(-w, w, -h, h, -B, B);
     }
     else
-      projectionMatrix = mat4::perspective(viewAngle, aspectRatio, F, B);
+      P = mat4d::perspective(viewAngle, aspectRatio, F, B);
     viewUp = vAxis(directionOfProjection, viewUp);
-    matrix = mat4::lookAt(position, focalPoint, viewUp);
-    matrix.inverse(inverseMatrix);
+
+    mat4d V = mat4d::lookAt(vec3d(position), vec3d(focalPoint), vec3d(viewUp));
+    mat4d I;
+
+    V.inverseAffine(I);
+    projectionMatrix = mat4(P);
+    matrix = mat4(V);
+    inverseMatrix = mat4(I);
+    vpMatrix = mat4(P * V);
     viewModified = false;
     timestamp++;
   }
@@ -498,6 +513,28 @@ Camera::getProjectionName() const
   return projectionName[projectionType];
 }
 
+REAL
+Camera::projectedSize(const Bounds3& box) const
+//[]---------------------------------------------------[]
+//|  Projected size                                     |
+//|                                                     |
+//|  Size of the projection of the bounding sphere of a |
+//|  box relative to the window height. A box enclosing |
+//|  the camera has infinite size.                      |
+//[]---------------------------------------------------[]
+{
+  REAL r = box.diagonalLength() * (REAL)0.5;
+
+  if (projectionType == Parallel)
+    return 2 * r / height;
+
+  REAL d = (box.center() - position).dot(directionOfProjection);
+
+  if (d <= r)
+    return FloatInfo<REAL>::inf();
+  return r / (d * REAL(tan(Math::toRadians<REAL>(viewAngle) * .5)));
+}
+
 void
 Camera::print(FILE* f) const
 //[]---------------------------------------------------[]
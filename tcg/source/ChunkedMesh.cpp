@@ -0,0 +1,574 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: ChunkedMesh.cpp
+//  ========
+//  Source file for out-of-core chunked triangle mesh.
+
+#include <stdio.h>
+#include <string.h>
+#include "ChunkedMesh.h"
+
+using namespace Graphics;
+
+//
+// Chunked mesh file layout:
+//
+// header:    magic[4], version, sizeof(REAL), flags, numberOfChunks,
+//            bounds (6 REALs)
+// directory: for each chunk, bounds (6 REALs), offset (int64),
+//            numberOfVertices, numberOfTriangles
+// chunks:    for each chunk, vertices, normals (optional),
+//            triangles, colors (optional)
+//
+#define CMF_MAGIC "TCGC"
+#define CMF_VERSION 1
+#define CMF_HEADER_SIZE (4 + 4 * sizeof(int) + 6 * sizeof(REAL))
+#define CMF_ENTRY_SIZE (6 * sizeof(REAL) + sizeof(int64) + 2 * sizeof(int))
+
+enum
+{
+  HasNormals = 1,
+  HasColors = 2
+};
+
+//
+// Auxiliary functions
+//
+inline int
+seekFile(FILE* file, int64 offset)
+{
+#ifdef _WIN32
+  return _fseeki64(file, offset, SEEK_SET);
+#else
+  return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+inline int64
+tellFile(FILE* file)
+{
+#ifdef _WIN32
+  return _ftelli64(file);
+#else
+  return (int64)ftello(file);
+#endif
+}
+
+inline int64
+fileSize(FILE* file)
+{
+  int64 offset = tellFile(file);
+  int64 size = -1;
+
+#ifdef _WIN32
+  if (_fseeki64(file, 0, SEEK_END) == 0)
+#else
+  if (fseeko(file, 0, SEEK_END) == 0)
+#endif
+    size = tellFile(file);
+  return seekFile(file, offset) == 0 ? size : -1;
+}
+
+template <typename T>
+inline bool
+writeArray(FILE* file, const T* a, int n)
+{
+  return fwrite(a, sizeof(T), n, file) == (size_t)n;
+}
+
+template <typename T>
+inline bool
+readArray(FILE* file, T* a, int n)
+{
+  return fread(a, sizeof(T), n, file) == (size_t)n;
+}
+
+inline bool
+writeBounds(FILE* file, const Bounds3& b)
+{
+  return writeArray(file, &b.getMin(), 1) && writeArray(file, &b.getMax(), 1);
+}
+
+inline bool
+readBounds(FILE* file, Bounds3& b)
+{
+  vec3 p[2];
+
+  if (!readArray(file, p, 2))
+    return false;
+  b.set(p[0], p[1]);
+  return true;
+}
+
+inline int64
+chunkSize(int nv, int nt, int flags)
+{
+  int64 s = nv * (int64)sizeof(vec3) +
+    nt * (int64)sizeof(TriangleMesh::Triangle);
+
+  if (flags & HasNormals)
+    s += nv * (int64)sizeof(vec3);
+  if (flags & HasColors)
+    s += nv * (int64)sizeof(Color);
+  return s;
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// ChunkBuilder: chunked mesh builder class
+// ============
+class ChunkBuilder
+{
+public:
+  struct Range
+  {
+    int first;
+    int last;
+
+  }; // Range
+
+  Array<Range> ranges;
+  int* order;
+
+  // Constructor
+  ChunkBuilder(const TriangleMesh::Arrays&, int);
+
+  // Destructor
+  ~ChunkBuilder()
+  {
+    delete []order;
+    delete []centroids;
+  }
+
+private:
+  vec3* centroids;
+  int maxTriangles;
+
+  void select(int, int, int, int);
+  void split(int, int);
+
+}; // ChunkBuilder
+
+ChunkBuilder::ChunkBuilder(const TriangleMesh::Arrays& data, int maxt):
+  ranges(64, 64),
+  maxTriangles(maxt)
+{
+  int nt = data.numberOfTriangles;
+
+  order = new int[nt];
+  centroids = new vec3[nt];
+  for (int i = 0; i < nt; i++)
+  {
+    order[i] = i;
+    centroids[i] = triangleCenter(data.vertices, data.triangles[i].v);
+  }
+  if (nt > 0)
+    split(0, nt);
+}
+
+void
+ChunkBuilder::select(int first, int last, int k, int axis)
+//[]---------------------------------------------------[]
+//|  Select                                             |
+//|                                                     |
+//|  Partition the triangles [first, last) so that the  |
+//|  k-th one is in its sorted position along the axis, |
+//|  the ones before it are not greater, and the ones   |
+//|  after it are not smaller (Hoare's selection).      |
+//[]---------------------------------------------------[]
+{
+  int lo = first;
+  int hi = last - 1;
+
+  while (lo < hi)
+  {
+    REAL pivot = centroids[order[(lo + hi) / 2]][axis];
+    int i = lo;
+    int j = hi;
+
+    while (i <= j)
+    {
+      while (centroids[order[i]][axis] < pivot)
+        i++;
+      while (centroids[order[j]][axis] > pivot)
+        j--;
+      if (i <= j)
+      {
+        int t = order[i];
+
+        order[i++] = order[j];
+        order[j--] = t;
+      }
+    }
+    // The triangles in (j, i) are equal to the pivot
+    if (k <= j)
+      hi = j;
+    else if (k >= i)
+      lo = i;
+    else
+      break;
+  }
+}
+
+void
+ChunkBuilder::split(int first, int last)
+//[]---------------------------------------------------[]
+//|  Split                                              |
+//|                                                     |
+//|  Recursively split the triangles [first, last) at   |
+//|  the median centroid along the longest axis of the  |
+//|  centroid bounds until each range fits a chunk.     |
+//[]---------------------------------------------------[]
+{
+  if (last - first <= maxTriangles)
+  {
+    Range r = {first, last};
+
+    ranges.add(r);
+    return;
+  }
+
+  Bounds3 b;
+
+  for (int i = first; i < last; i++)
+    b.inflate(centroids[order[i]]);
+
+  vec3 s = b.size();
+  int axis = s.x > s.y ? (s.x > s.z ? 0 : 2) : (s.y > s.z ? 1 : 2);
+  int mid = (first + last) / 2;
+
+  select(first, last, mid, axis);
+  split(first, mid);
+  split(mid, last);
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// ChunkedMesh implementation
+// ===========
+bool
+ChunkedMesh::write(const char* fileName, const TriangleMesh& mesh, int maxt)
+//[]---------------------------------------------------[]
+//|  Write chunked mesh file                            |
+//[]---------------------------------------------------[]
+{
+  const TriangleMesh::Arrays& data = mesh.getData();
+  int nv = data.numberOfVertices;
+  int flags = 0;
+
+  if (data.normals != 0 && data.numberOfNormals == nv)
+    flags |= HasNormals;
+  // Only per-vertex colors are preserved
+  if (data.colors != 0 && data.numberOfColors == nv)
+    flags |= HasColors;
+
+  FILE* file = fopen(fileName, "wb");
+
+  if (file == 0)
+    return false;
+  if (maxt <= 0)
+    maxt = DFL_CHUNK_SIZE;
+
+  ChunkBuilder builder(data, maxt);
+  int nc = builder.ranges.size();
+  int header[] = {CMF_VERSION, (int)sizeof(REAL), flags, nc};
+  Chunk* chunks = new Chunk[nc];
+  int* local = new int[nv];
+  int* global = new int[nv];
+  vec3* vertices = new vec3[nv];
+  vec3* normals = new vec3[nv];
+  Color* colors = new Color[nv];
+  TriangleMesh::Triangle* triangles = new TriangleMesh::Triangle[maxt];
+  bool ok = fwrite(CMF_MAGIC, 4, 1, file) == 1 &&
+    writeArray(file, header, 4) &&
+    writeBounds(file, mesh.boundingBox());
+  // Reserve the directory; it is written after the chunks
+  int64 directory = tellFile(file);
+  int64 offset = directory + nc * (int64)CMF_ENTRY_SIZE;
+
+  memset(local, -1, nv * sizeof(int));
+  ok = ok && seekFile(file, offset) == 0;
+  for (int c = 0; ok && c < nc; c++)
+  {
+    const ChunkBuilder::Range& r = builder.ranges[c];
+    Chunk& chunk = chunks[c];
+    int n = 0;
+    int nt = r.last - r.first;
+
+    for (int i = 0; i < nt; i++)
+    {
+      const TriangleMesh::Triangle& t = data.triangles[builder.order[r.first + i]];
+
+      for (int k = 0; k < 3; k++)
+      {
+        int v = t.v[k];
+
+        if (local[v] < 0)
+        {
+          global[n] = v;
+          local[v] = n++;
+        }
+        triangles[i].v[k] = local[v];
+      }
+    }
+    for (int i = 0; i < n; i++)
+    {
+      int v = global[i];
+
+      vertices[i] = data.vertices[v];
+      chunk.bounds.inflate(vertices[i]);
+      if (flags & HasNormals)
+        normals[i] = data.normals[v];
+      if (flags & HasColors)
+        colors[i] = data.colors[v];
+      local[v] = -1;
+    }
+    chunk.offset = offset;
+    chunk.numberOfVertices = n;
+    chunk.numberOfTriangles = nt;
+    chunk.size = chunkSize(n, nt, flags);
+    ok = writeArray(file, vertices, n);
+    if (ok && (flags & HasNormals))
+      ok = writeArray(file, normals, n);
+    ok = ok && writeArray(file, triangles, nt);
+    if (ok && (flags & HasColors))
+      ok = writeArray(file, colors, n);
+    offset += chunk.size;
+  }
+  ok = ok && seekFile(file, directory) == 0;
+  for (int c = 0; ok && c < nc; c++)
+  {
+    const Chunk& chunk = chunks[c];
+
+    ok = writeBounds(file, chunk.bounds) &&
+      writeArray(file, &chunk.offset, 1) &&
+      writeArray(file, &chunk.numberOfVertices, 1) &&
+      writeArray(file, &chunk.numberOfTriangles, 1);
+  }
+  delete []triangles;
+  delete []colors;
+  delete []normals;
+  delete []vertices;
+  delete []global;
+  delete []local;
+  delete []chunks;
+  return fclose(file) == 0 && ok;
+}
+
+ChunkedMesh*
+ChunkedMesh::open(const char* fileName, int64 cacheSize)
+//[]---------------------------------------------------[]
+//|  Open chunked mesh file                             |
+//[]---------------------------------------------------[]
+{
+  FILE* file = fopen(fileName, "rb");
+
+  if (file == 0)
+    return 0;
+
+  char magic[4];
+  int header[4];
+  // The sizes read from the file are checked against the file size
+  // before anything is allocated from them
+  int64 size = fileSize(file);
+
+  if (fread(magic, 4, 1, file) != 1 || memcmp(magic, CMF_MAGIC, 4) != 0 ||
+    !readArray(file, header, 4) ||
+    header[0] != CMF_VERSION ||
+    header[1] != sizeof(REAL) ||
+    header[3] < 0 ||
+    header[3] > (size - (int64)CMF_HEADER_SIZE) / (int64)CMF_ENTRY_SIZE)
+  {
+    fclose(file);
+    return 0;
+  }
+
+  ChunkedMesh* mesh = new ChunkedMesh(file, cacheSize);
+  int nc = header[3];
+  bool ok = readBounds(file, mesh->bounds);
+
+  mesh->flags = header[2];
+  mesh->chunks = new Chunk[nc];
+  for (int c = 0; ok && c < nc; c++)
+  {
+    Chunk& chunk = mesh->chunks[c];
+
+    ok = readBounds(file, chunk.bounds) &&
+      readArray(file, &chunk.offset, 1) &&
+      readArray(file, &chunk.numberOfVertices, 1) &&
+      readArray(file, &chunk.numberOfTriangles, 1) &&
+      chunk.numberOfVertices >= 0 &&
+      chunk.numberOfTriangles >= 0;
+    chunk.size = chunkSize(chunk.numberOfVertices,
+      chunk.numberOfTriangles,
+      mesh->flags);
+    ok = ok && chunk.offset >= 0 && chunk.offset <= size - chunk.size;
+  }
+  if (!ok)
+  {
+    delete mesh;
+    return 0;
+  }
+  mesh->numberOfChunks = nc;
+  mesh->entries = new CacheEntry*[nc];
+  memset(mesh->entries, 0, nc * sizeof(CacheEntry*));
+  return mesh;
+}
+
+ChunkedMesh::ChunkedMesh(FILE* f, int64 size):
+  file(f),
+  flags(0),
+  numberOfChunks(0),
+  chunks(0),
+  entries(0),
+  cacheSize(size),
+  cacheUsage(0)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  memset(&stats, 0, sizeof(Statistics));
+}
+
+ChunkedMesh::~ChunkedMesh()
+//[]---------------------------------------------------[]
+//|  Destructor                                         |
+//[]---------------------------------------------------[]
+{
+  lru.clear();
+  delete []entries;
+  delete []chunks;
+  fclose(file);
+}
+
+TriangleMesh*
+ChunkedMesh::readChunk(int id)
+//[]---------------------------------------------------[]
+//|  Read chunk                                         |
+//[]---------------------------------------------------[]
+{
+  const Chunk& chunk = chunks[id];
+  int nv = chunk.numberOfVertices;
+  int nt = chunk.numberOfTriangles;
+
+  if (seekFile(file, chunk.offset) != 0)
+    return 0;
+
+  // The arrays of a chunk are allocated in a single block, owned
+  // by the mesh even when reading fails
+  TriangleMesh::Block* block = TriangleMesh::Block::New(nv,
+    flags & HasNormals ? nv : 0,
+    nt,
+    flags & HasColors ? nv : 0);
+
+  if (block == 0)
+    return 0;
+
+  TriangleMesh::Arrays data = block->getArrays();
+  TriangleMesh* mesh = new TriangleMesh(block);
+  bool ok = readArray(file, data.vertices, nv);
+
+  if (ok && data.normals != 0)
+    ok = readArray(file, data.normals, nv);
+  ok = ok && readArray(file, data.triangles, nt);
+  if (ok && data.colors != 0)
+    ok = readArray(file, data.colors, nv);
+  if (!ok)
+  {
+    delete mesh;
+    return 0;
+  }
+  return mesh;
+}
+
+void
+ChunkedMesh::evict(int id)
+//[]---------------------------------------------------[]
+//|  Evict chunk                                        |
+//|                                                     |
+//|  The chunk mesh is deleted only if no one else is   |
+//|  using it.                                          |
+//[]---------------------------------------------------[]
+{
+  CacheEntry* e = entries[id];
+
+  if (e != 0)
+  {
+    lru.remove(*e);
+    entries[id] = 0;
+    cacheUsage -= chunks[id].size;
+    stats.evictions++;
+    delete e;
+  }
+}
+
+TriangleMesh*
+ChunkedMesh::getChunk(int id)
+//[]---------------------------------------------------[]
+//|  Get chunk                                          |
+//|                                                     |
+//|  The returned mesh is valid until it is evicted     |
+//|  from the cache; callers that keep a chunk across   |
+//|  calls must hold it through an ObjectPtr.           |
+//[]---------------------------------------------------[]
+{
+  PRECONDITION(id >= 0 && id < numberOfChunks);
+
+  CacheEntry* e = entries[id];
+
+  if (e != 0)
+  {
+    stats.hits++;
+    if (e != lru.peekHead())
+    {
+      lru.remove(*e);
+      lru.addAtHead(e);
+    }
+    return e->mesh;
+  }
+  stats.misses++;
+
+  TriangleMesh* mesh = readChunk(id);
+
+  if (mesh == 0)
+    return 0;
+
+  int64 size = chunks[id].size;
+
+  while (cacheUsage + size > cacheSize && !lru.isEmpty())
+    evict(lru.peekTail()->id);
+  lru.addAtHead(e = entries[id] = new CacheEntry(mesh, id));
+  cacheUsage += size;
+  return mesh;
+}
+
+void
+ChunkedMesh::setCacheSize(int64 size)
+//[]---------------------------------------------------[]
+//|  Set cache size                                     |
+//[]---------------------------------------------------[]
+{
+  cacheSize = size;
+  while (cacheUsage > cacheSize && !lru.isEmpty())
+    evict(lru.peekTail()->id);
+}
+
+void
+ChunkedMesh::flush()
+//[]---------------------------------------------------[]
+//|  Flush cache                                        |
+//[]---------------------------------------------------[]
+{
+  while (!lru.isEmpty())
+    evict(lru.peekTail()->id);
+}
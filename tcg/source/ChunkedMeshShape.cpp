@@ -0,0 +1,67 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: ChunkedMeshShape.cpp
+//  ========
+//  Source file for chunked triangle mesh shape.
+
+#include "ChunkedMeshShape.h"
+
+using namespace Graphics;
+
+
+//////////////////////////////////////////////////////////
+//
+// ChunkedMeshShape implementation
+// ================
+Object*
+ChunkedMeshShape::clone() const
+//[]---------------------------------------------------[]
+//|  Make copy                                          |
+//|                                                     |
+//|  The chunked mesh is read-only, so it is shared.    |
+//[]---------------------------------------------------[]
+{
+  ChunkedMeshShape* shape = new ChunkedMeshShape(mesh);
+
+  shape->setMatrix(matrix, inverseMatrix);
+  shape->setMaterial(material);
+  return shape;
+}
+
+const TriangleMesh*
+ChunkedMeshShape::triangleMesh() const
+//[]---------------------------------------------------[]
+//|  Triangle mesh                                      |
+//[]---------------------------------------------------[]
+{
+  return 0;
+}
+
+ChunkedMesh*
+ChunkedMeshShape::chunkedMesh() const
+//[]---------------------------------------------------[]
+//|  Chunked mesh                                       |
+//[]---------------------------------------------------[]
+{
+  return mesh;
+}
+
+Bounds3
+ChunkedMeshShape::boundingBox() const
+//[]---------------------------------------------------[]
+//|  Bounding box                                       |
+//[]---------------------------------------------------[]
+{
+  Bounds3 b = mesh->boundingBox();
+
+  b.transform(this->matrix);
+  return b;
+}
@@ -29,6 +29,7 @@ const char* vertexShader =
   "layout (location = 1) in vec3 normal;\n"
   "uniform mat4 vpMatrix;\n"
   "uniform mat4 modelMatrix;\n"
+  "uniform mat3 normalMatrix;\n"
   "uniform vec4 Oa;\n"
   "uniform vec4 Od;\n"
   "uniform vec4 ambientLight = vec4(1, 1, 1, 1);\n"
@@ -38,7 +39,7 @@ const char* vertexShader =
   "void main() {\n"
   "  vec4 P = modelMatrix * position;\n"
   "  gl_Position = vpMatrix * P;\n"
-  "  vec3 N = normalize(mat3(modelMatrix) * normal);\n"
+  "  vec3 N = normalize(normalMatrix * normal);\n"
   "  vec4 L = normalize(P - lightPosition);\n"
   "  float cos_theta = -dot(N, vec3(L));\n"
   "  color = Oa * ambientLight;\n"
@@ -100,6 +101,15 @@ GLVertexArray::render()
   glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
 }
 
+inline void
+GLVertexArray::render(int first, int n)
+{
+  const GLvoid* offset = (const GLvoid*)sizeOf<TriangleMesh::Triangle>(first);
+
+  glBindVertexArray(vao);
+  glDrawElements(GL_TRIANGLES, 3 * n, GL_UNSIGNED_INT, offset);
+}
+
 GLVertexArray::~GLVertexArray()
 {
   glDeleteBuffers(3, buffers);
@@ -114,15 +124,19 @@ GLVertexArray::~GLVertexArray()
 GLRenderer::GLRenderer(Scene& scene, Camera* camera):
   Renderer(scene, camera),
   renderMode(Smooth),
-  program("renderer program")
+  lodThreshold(1),
+  program("renderer program"),
+  culledActors(0),
+  occludedActors(0)
 {
-  flags.set(UseLights);
+  flags.set(UseLights | CullActors);
   glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
   program.addShader(GL_VERTEX_SHADER, GLSL::STRING, vertexShader);
   program.addShader(GL_FRAGMENT_SHADER, GLSL::STRING, fragmentShader);
   program.use();
   vpMatrixLoc = program.getUniformLocation("vpMatrix");
   modelMatrixLoc = program.getUniformLocation("modelMatrix");
+  normalMatrixLoc = program.getUniformLocation("normalMatrix");
   OaLoc = program.getUniformLocation("Oa");
   OdLoc = program.getUniformLocation("Od");
   ambientLightLoc = program.getUniformLocation("ambientLight");
@@ -154,18 +168,13 @@ GLRenderer::drawAABB(const Bounds3& box) const
   drawLine(p1, p5);
 }
 
-inline mat4
-getVpMatrix(Camera* c)
-{
-  return c->getProjectionMatrix() * c->getWorldToCameraMatrix();
-}
-
 void
 GLRenderer::update()
 {
   Renderer::update();
-  vpMatrix = getVpMatrix(camera);
-  program.setUniform(vpMatrixLoc, vpMatrix);
+  vpMatrix = camera->getViewProjectionMatrix();
+  frustum.set(vpMatrix);
+  program.setUniform(vpMatrixLoc, mat4f(vpMatrix));
   program.setUniform(ambientLightLoc, scene->ambientLight);
   glViewport(0, 0, W, H);
 }
@@ -239,52 +248,192 @@ vertexArray(TriangleMesh* mesh)
 }
 
 void
-GLRenderer::drawMesh(const Model* model) const
+GLRenderer::drawGeometry(const Model* model,
+  TriangleMesh* mesh,
+  const mat4& matrix) const
 {
-  TriangleMesh* mesh = (TriangleMesh*)model->triangleMesh();
+  ChunkedMesh* chunks = model->chunkedMesh();
 
-  if (mesh == 0)
+  if (mesh == 0 && chunks == 0)
     return;
-  if (GLVertexArray* vb = vertexArray(mesh))
+  if (mesh == 0)
   {
-    const Material* m = model->getMaterial();
-
-    program.setUniform(modelMatrixLoc, model->getMatrix());
-    program.setUniform(OaLoc, m->surface.ambient);
-    program.setUniform(OdLoc, m->surface.diffuse);
-    vb->render();
+    // Chunks are paged in on demand; the vertex array of a chunk
+    // is released when the chunk is evicted from the cache. Only
+    // the chunks in the view frustum are requested, so that the
+    // cache is not flushed by the chunks out of view. The frustum
+    // is taken to mesh space, where the chunk bounds are given
+    Frustum meshFrustum(vpMatrix * matrix);
+    bool cull = flags.isSet(CullActors);
+
+    for (int i = 0, n = chunks->getNumberOfChunks(); i < n; i++)
+    {
+      if (cull && meshFrustum.isOutside(chunks->chunkBounds(i)))
+        continue;
+      if (TriangleMesh* chunk = chunks->getChunk(i))
+        vertexArray(chunk)->render();
+    }
   }
+  else if (flags.isSet(CullMeshlets) && mesh->getMeshlets() != 0)
+    drawMeshlets(matrix, mesh);
+  else
+    vertexArray(mesh)->render();
 }
 
 void
-GLRenderer::renderWireframe()
+GLRenderer::drawMeshlets(const mat4& matrix, TriangleMesh* mesh) const
 {
-  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-  for (ActorIterator ait(scene->getActorIterator()); ait;)
+  const TriangleMesh::Meshlets* m = mesh->getMeshlets();
+  mat4 mvp = vpMatrix * matrix;
+  // The normal cones are tested against the viewpoint in mesh space
+  mat4 inverse;
+  bool useCones = camera->getProjectionType() == Camera::Perspective &&
+    matrix.inverseAffine(inverse);
+  vec3 eye = useCones ?
+    inverse.transform3x4(camera->getPosition()) :
+    vec3::null();
+  GLVertexArray* va = vertexArray(mesh);
+  int first = 0;
+  int count = 0;
+
+  // Adjacent visible meshlets are drawn by a single call
+  for (int i = 0; i < m->numberOfMeshlets; i++)
   {
-    Actor* a = ait++;
+    const TriangleMesh::Meshlet& meshlet = m->meshlets[i];
 
-    if (!a->isVisible())
+    if (meshlet.isOutside(mvp) || (useCones && meshlet.isBackfacing(eye)))
       continue;
-    drawMesh(a->getModel());
-    /*
-    if (const TriangleMesh* mesh = a->getModel()->triangleMesh())
+    if (first + count == meshlet.firstTriangle)
+      count += meshlet.numberOfTriangles;
+    else
     {
-      const TriangleMesh::Arrays& meshData = mesh->getData();
-      vec3* vertices = meshData.vertices;
-      TriangleMesh::Triangle* triangles = meshData.triangles;
-
-      glBegin(GL_TRIANGLES);
-      for (int i = 0, n = meshData.numberOfTriangles; i < n; i++)
-        for (int d = 0; d < 3; d++)
-        {
-          const vec3& p = vertices[triangles[i].v[d]];
-          glVertex3f((float)p.x, (float)p.y, (float)p.z);
-        }
-      glEnd();
+      if (count != 0)
+        va->render(first, count);
+      first = meshlet.firstTriangle;
+      count = meshlet.numberOfTriangles;
     }
-    */
   }
+  if (count != 0)
+    va->render(first, count);
+}
+
+void
+GLRenderer::drawActor(const ActorTable& table, int i)
+{
+  // The matrix, bounds, mesh, and material come from the actor
+  // table row rather than from the model; GLSL takes float
+  // matrices, whatever REAL is
+  const Model* model = table.getActor(i)->getModel();
+  const TriangleMesh* mesh = rowMesh(table, i, lodThreshold / H);
+  const Material* m = table.getMaterial(table.getMaterialIds()[i]);
+
+  program.setUniform(modelMatrixLoc, mat4f(table.getMatrices()[i]));
+  program.setUniform(normalMatrixLoc, mat3f(table.getNormalMatrices()[i]));
+  program.setUniform(OaLoc, m->surface.ambient);
+  program.setUniform(OdLoc, m->surface.diffuse);
+  drawGeometry(model, (TriangleMesh*)mesh, table.getMatrices()[i]);
+}
+
+const TriangleMesh*
+GLRenderer::rowMesh(const ActorTable& table, int i, REAL maxError)
+{
+  Actor* actor = table.getActor(i);
+  int lod = actor->selectLOD(*camera, maxError, table.getBounds()[i]);
+
+  return lod == 0 ? table.getMeshes()[i] : actor->getModel()->lodMesh(lod);
+}
+
+void
+GLRenderer::cullActors(const ActorTable& table)
+{
+  const Flags* actorFlags = table.getFlags();
+  const Bounds3* bounds = table.getBounds();
+  int n = table.size();
+
+  visibleRows.clear();
+  culledActors = occludedActors = 0;
+  if (!flags.isSet(CullActors))
+  {
+    for (int i = 0; i < n; i++)
+      if (actorFlags[i].isSet(Actor::Visible))
+        visibleRows.add(i);
+    if (flags.isSet(CullOccluded))
+      cullOccludedActors(table);
+    return;
+  }
+  // The world bounds of the rows are tested against the frustum
+  // four at a time
+  for (int i = 0; i < n; i += 4)
+  {
+    int m = dMin<int>(n - i, 4);
+    Bounds3x4 packet;
+
+    for (int j = 0; j < m; j++)
+      packet.set(j, bounds[i + j]);
+
+    int mask = frustum.intersect(packet);
+
+    for (int j = 0; j < m; j++)
+    {
+      if (!actorFlags[i + j].isSet(Actor::Visible))
+        continue;
+      if (mask & (1 << j))
+        visibleRows.add(i + j);
+      else
+        culledActors++;
+    }
+  }
+  if (flags.isSet(CullOccluded))
+    cullOccludedActors(table);
+}
+
+void
+GLRenderer::cullOccludedActors(const ActorTable& table)
+{
+  const Flags* actorFlags = table.getFlags();
+  const Bounds3* bounds = table.getBounds();
+  // The occluders are drawn with the coarsest LOD whose error does
+  // not exceed a texel of the depth buffer of the culler
+  REAL maxError = Math::inverse<REAL>(REAL(occlusionCuller.getHeight()));
+  int n = visibleRows.size();
+  int k = 0;
+
+  occlusionCuller.begin(vpMatrix);
+  for (int j = 0; j < n; j++)
+  {
+    int i = visibleRows[j];
+
+    if (actorFlags[i].isSet(Actor::Occluder))
+      if (const TriangleMesh* mesh = rowMesh(table, i, maxError))
+        occlusionCuller.addOccluder(*mesh, table.getMatrices()[i]);
+  }
+  occlusionCuller.end();
+  for (int j = 0; j < n; j++)
+  {
+    int i = visibleRows[j];
+
+    // An occluder would be hidden by its own depth, so occluders
+    // are kept
+    if (!actorFlags[i].isSet(Actor::Occluder) &&
+      occlusionCuller.isOccluded(bounds[i]))
+      occludedActors++;
+    else
+      visibleRows[k++] = i;
+  }
+  while (visibleRows.size() > k)
+    visibleRows.removeAt(visibleRows.size() - 1);
+}
+
+void
+GLRenderer::renderWireframe()
+{
+  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+  const ActorTable& table = scene->getActorTable();
+
+  cullActors(table);
+  for (int k = 0, n = visibleRows.size(); k < n; k++)
+    drawActor(table, visibleRows[k]);
 }
 
 void
@@ -294,14 +443,12 @@ GLRenderer::renderFaces()
     drawAABB(scene->boundingBox());
   glPolygonMode(GL_FRONT, GL_FILL);
   glEnable(GL_DEPTH_TEST);
-  for (ActorIterator ait(scene->getActorIterator()); ait;)
-  {
-    Actor* a = ait++;
 
-    if (!a->isVisible())
-      continue;
-    drawMesh(a->getModel());
-  }
+  const ActorTable& table = scene->getActorTable();
+
+  cullActors(table);
+  for (int k = 0, n = visibleRows.size(); k < n; k++)
+    drawActor(table, visibleRows[k]);
   glDisable(GL_DEPTH_TEST);
 }
 
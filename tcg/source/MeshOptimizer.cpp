@@ -0,0 +1,280 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: MeshOptimizer.cpp
+//  ========
+//  Source file for mesh optimizer.
+
+#include <math.h>
+#include <string.h>
+#include "MeshOptimizer.h"
+
+using namespace Graphics;
+
+//
+// Vertex cache model used by the triangle reordering
+// (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+//
+#define CACHE_SIZE     32
+#define CACHE_DECAY    1.5f
+#define LAST_TRI_SCORE 0.75f
+#define VALENCE_SCALE  2.0f
+#define VALENCE_POWER  0.5f
+
+//
+// Auxiliary functions
+//
+inline float
+vertexScore(int cachePosition, int valence)
+{
+  if (valence == 0)
+    return -1;
+
+  float score = 0;
+
+  if (cachePosition >= 3)
+  {
+    float s = 1 - float(cachePosition - 3) / (CACHE_SIZE - 3);
+    score = powf(s, CACHE_DECAY);
+  }
+  else if (cachePosition >= 0)
+    // The vertices of the last triangle get a fixed score, so that
+    // the order they were used in does not matter
+    score = LAST_TRI_SCORE;
+  // Favor vertices with few remaining triangles
+  return score + VALENCE_SCALE * powf(float(valence), -VALENCE_POWER);
+}
+
+template <typename T>
+inline void
+permuteArray(T* a, const int* remap, int n)
+{
+  // The array is permuted in place, since it may live in a mesh block
+  T* p = new T[n];
+
+  memcpy(p, a, n * sizeof(T));
+  for (int i = 0; i < n; i++)
+    a[remap[i]] = p[i];
+  delete []p;
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// MeshOptimizer implementation
+// =============
+REAL
+MeshOptimizer::ACMR(const TriangleMesh::Arrays& data, int cacheSize)
+//[]---------------------------------------------------[]
+//|  ACMR                                               |
+//[]---------------------------------------------------[]
+{
+  int nt = data.numberOfTriangles;
+
+  if (nt == 0)
+    return 0;
+
+  int nv = data.numberOfVertices;
+  int* time = new int[nv];
+  int misses = 0;
+
+  // A vertex is in the FIFO cache if fewer than cacheSize
+  // vertices were inserted after it
+  for (int i = 0; i < nv; i++)
+    time[i] = -cacheSize;
+  for (int i = 0; i < nt; i++)
+    for (int k = 0; k < 3; k++)
+    {
+      int v = data.triangles[i].v[k];
+
+      if (misses - time[v] >= cacheSize)
+        time[v] = misses++;
+    }
+  delete []time;
+  return REAL(misses) / nt;
+}
+
+void
+MeshOptimizer::optimizeVertexCache(TriangleMesh::Arrays& data)
+//[]---------------------------------------------------[]
+//|  Optimize vertex cache                              |
+//|                                                     |
+//|  Greedy triangle reordering: the next triangle is   |
+//|  the best scored one among the triangles of the     |
+//|  vertices in a simulated LRU cache.                 |
+//[]---------------------------------------------------[]
+{
+  int nv = data.numberOfVertices;
+  int nt = data.numberOfTriangles;
+
+  if (nt == 0)
+    return;
+
+  TriangleMesh::VertexTriangles vt(data);
+  const TriangleMesh::Triangle* triangles = data.triangles;
+  int* valence = new int[nv];
+  int* position = new int[nv];
+  float* vscore = new float[nv];
+  float* tscore = new float[nt];
+  bool* emitted = new bool[nt];
+  TriangleMesh::Triangle* output = new TriangleMesh::Triangle[nt];
+  int cache[CACHE_SIZE + 3];
+  int cacheCount = 0;
+
+  for (int v = 0; v < nv; v++)
+  {
+    valence[v] = vt.end(v) - vt.begin(v);
+    position[v] = -1;
+    vscore[v] = vertexScore(-1, valence[v]);
+  }
+
+  int best = 0;
+
+  for (int i = 0; i < nt; i++)
+  {
+    const int* v = triangles[i].v;
+
+    tscore[i] = vscore[v[0]] + vscore[v[1]] + vscore[v[2]];
+    emitted[i] = false;
+    if (tscore[i] > tscore[best])
+      best = i;
+  }
+  for (int n = 0, cursor = 0; n < nt; n++)
+  {
+    // If no candidate was found in the cache, take the next
+    // triangle not emitted yet
+    if (best < 0)
+    {
+      while (emitted[cursor])
+        cursor++;
+      best = cursor;
+    }
+
+    const int* tv = triangles[best].v;
+    int newCache[CACHE_SIZE + 3];
+    int newCount = 0;
+
+    output[n] = triangles[best];
+    emitted[best] = true;
+    // The vertices of the emitted triangle go to the front of
+    // the cache, followed by the other vertices in LRU order
+    for (int k = 0; k < 3; k++)
+    {
+      valence[tv[k]]--;
+      newCache[newCount++] = tv[k];
+    }
+    for (int i = 0; i < cacheCount; i++)
+    {
+      int v = cache[i];
+
+      if (v != tv[0] && v != tv[1] && v != tv[2])
+        newCache[newCount++] = v;
+    }
+    for (int i = CACHE_SIZE; i < newCount; i++)
+    {
+      position[newCache[i]] = -1;
+      vscore[newCache[i]] = vertexScore(-1, valence[newCache[i]]);
+    }
+    cacheCount = dMin<int>(newCount, CACHE_SIZE);
+    for (int i = 0; i < cacheCount; i++)
+    {
+      int v = cache[i] = newCache[i];
+
+      position[v] = i;
+      vscore[v] = vertexScore(i, valence[v]);
+    }
+
+    // Rescore the triangles of the vertices whose scores changed
+    // and choose the best one as the next candidate
+    float bestScore = -1;
+
+    best = -1;
+    for (int i = 0; i < newCount; i++)
+    {
+      int v = newCache[i];
+
+      for (int j = vt.begin(v), e = vt.end(v); j < e; j++)
+      {
+        int t = vt.corners[j] / 3;
+
+        if (emitted[t])
+          continue;
+
+        const int* w = triangles[t].v;
+
+        tscore[t] = vscore[w[0]] + vscore[w[1]] + vscore[w[2]];
+        if (i < cacheCount && tscore[t] > bestScore)
+        {
+          bestScore = tscore[t];
+          best = t;
+        }
+      }
+    }
+  }
+  memcpy(data.triangles, output, nt * sizeof(TriangleMesh::Triangle));
+  delete []output;
+  delete []emitted;
+  delete []tscore;
+  delete []vscore;
+  delete []position;
+  delete []valence;
+}
+
+void
+MeshOptimizer::optimizeVertexFetch(TriangleMesh::Arrays& data)
+//[]---------------------------------------------------[]
+//|  Optimize vertex fetch                              |
+//|                                                     |
+//|  Vertices are renumbered in the order they are      |
+//|  first used by the triangles; unused vertices are   |
+//|  moved to the end of the arrays.                    |
+//[]---------------------------------------------------[]
+{
+  int nv = data.numberOfVertices;
+  int nt = data.numberOfTriangles;
+  int* remap = new int[nv];
+  int next = 0;
+
+  memset(remap, -1, nv * sizeof(int));
+  for (int i = 0; i < nt; i++)
+    for (int k = 0; k < 3; k++)
+    {
+      int& v = data.triangles[i].v[k];
+
+      if (remap[v] < 0)
+        remap[v] = next++;
+      v = remap[v];
+    }
+  for (int v = 0; v < nv; v++)
+    if (remap[v] < 0)
+      remap[v] = next++;
+  permuteArray(data.vertices, remap, nv);
+  // Only per-vertex attributes are reordered
+  if (data.normals != 0 && data.numberOfNormals == nv)
+    permuteArray(data.normals, remap, nv);
+  if (data.colors != 0 && data.numberOfColors == nv)
+    permuteArray(data.colors, remap, nv);
+  delete []remap;
+}
+
+MeshOptimizer::Statistics
+MeshOptimizer::execute(TriangleMesh::Arrays& data)
+//[]---------------------------------------------------[]
+//|  Execute                                            |
+//[]---------------------------------------------------[]
+{
+  Statistics stats;
+
+  stats.acmrBefore = ACMR(data);
+  optimizeVertexCache(data);
+  optimizeVertexFetch(data);
+  stats.acmrAfter = ACMR(data);
+  return stats;
+}
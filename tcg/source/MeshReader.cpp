@@ -13,6 +13,7 @@
 //  Source file for mesh sweeper.
 
 #include <stdio.h>
+#include "MeshOptimizer.h"
 #include "MeshReader.h"
 
 using namespace Graphics;
@@ -39,20 +40,21 @@ readMaterialFile(const char* fileName)
 
       case 'N':
       {
-        REAL shininess;
+        float shininess;
 
         fscanf(file, "%f", &shininess);
         // wavefront shininess is from [0, 1000], so scale for OpenGL
-        shininess *= REAL(128.0 / 1000.0);
+        shininess *= float(128.0 / 1000.0);
         material->surface.shine = shininess;
         break;
       }
 
       case 'K':
       {
-        REAL r;
-        REAL g;
-        REAL b;
+        // Color components are float, whatever REAL is
+        float r;
+        float g;
+        float b;
 
         switch(strm[1])
         {
@@ -185,20 +187,21 @@ readMeshData(FILE* file, TriangleMesh::Arrays& data)
     {
       case 'v':
       {
-        REAL x;
-        REAL y;
-        REAL z;
+        // Coordinates are read in double, whatever REAL is
+        double x;
+        double y;
+        double z;
 
         switch (strm[1])
         {
           case '\0':
-            fscanf(file, "%f %f %f", &x, &y, &z);
-            vertex->set(x, y, z);
+            fscanf(file, "%lf %lf %lf", &x, &y, &z);
+            vertex->set(REAL(x), REAL(y), REAL(z));
             vertex++;
             break;
 
           case 'n':
-            fscanf(file, "%f %f %f", &x, &y, &z);
+            fscanf(file, "%lf %lf %lf", &x, &y, &z);
             // normal->set(x, y, z);
             // normal++;
             break;
@@ -355,22 +358,38 @@ MeshReader::execute(const char* fileName)
   TriangleMesh::Arrays data;
 
   readMeshSize(file, data);
-  data.vertices = new vec3[data.numberOfVertices];
-  if (data.numberOfNormals != 0)
-    data.normals = new vec3[data.numberOfNormals];
-  data.triangles = new TriangleMesh::Triangle[data.numberOfTriangles];
+
+  // The arrays are allocated in a single block; the normals are
+  // computed by the mesh
+  TriangleMesh::Block* block = TriangleMesh::Block::New(data.numberOfVertices,
+    data.numberOfVertices,
+    data.numberOfTriangles,
+    0);
+
+  if (block == 0)
+  {
+    fclose(file);
+    return 0;
+  }
+  data = block->getArrays();
   rewind(file);
   printf("Reading Wavefront OBJ file %s... ", fileName);
   readMeshData(file, data);
   fclose(file);
   puts("done");
+
+  MeshOptimizer::Statistics stats = MeshOptimizer::execute(data);
+
+  printf("Optimizing mesh... ACMR %.3f -> %.3f\n",
+    stats.acmrBefore,
+    stats.acmrAfter);
   /*
   file = fopen("a.msh", "w");
   data.print(file);
   fclose(file);
   */
 
-  TriangleMesh* mesh = new TriangleMesh(data);
+  TriangleMesh* mesh = new TriangleMesh(block);
 
   mesh->computeNormals();
   return mesh;
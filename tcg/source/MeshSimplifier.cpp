@@ -0,0 +1,662 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2010-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: MeshSimplifier.cpp
+//  ========
+//  Source file for mesh simplifier.
+
+#include <math.h>
+#include <string.h>
+#include "Array.h"
+#include "MeshSimplifier.h"
+
+using namespace Graphics;
+using namespace System::Collections;
+
+#define BOUNDARY_WEIGHT 1000.0
+
+
+//////////////////////////////////////////////////////////
+//
+// Quadric: error quadric class
+// =======
+class Quadric
+{
+public:
+  // Constructors
+  Quadric()
+  {
+    memset(q, 0, sizeof(q));
+  }
+
+  // Quadric of the plane n.p + d = 0, with |n| = 1
+  Quadric(const vec3& n, double d, double w = 1)
+  {
+    double a = n.x, b = n.y, c = n.z;
+
+    q[0] = w * a * a; q[1] = w * a * b; q[2] = w * a * c; q[3] = w * a * d;
+    q[4] = w * b * b; q[5] = w * b * c; q[6] = w * b * d;
+    q[7] = w * c * c; q[8] = w * c * d;
+    q[9] = w * d * d;
+  }
+
+  Quadric& operator +=(const Quadric& b)
+  {
+    for (int i = 0; i < 10; i++)
+      q[i] += b.q[i];
+    return *this;
+  }
+
+  Quadric operator +(const Quadric& b) const
+  {
+    return Quadric(*this) += b;
+  }
+
+  double evaluate(const vec3& p) const
+  {
+    double x = p.x, y = p.y, z = p.z;
+
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z +
+      2 * q[3] * x + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+      q[7] * z * z + 2 * q[8] * z + q[9];
+  }
+
+  // Find the point minimizing the quadric, if any
+  bool optimize(vec3& p) const
+  {
+    double det = DET3(q[0], q[1], q[2], q[1], q[4], q[5], q[2], q[5], q[7]);
+
+    if (fabs(det) < 1e-12)
+      return false;
+    det = 1 / det;
+
+    double bx = -q[3], by = -q[6], bz = -q[8];
+
+    p.x = REAL(det * DET3(bx, q[1], q[2], by, q[4], q[5], bz, q[5], q[7]));
+    p.y = REAL(det * DET3(q[0], bx, q[2], q[1], by, q[5], q[2], bz, q[7]));
+    p.z = REAL(det * DET3(q[0], q[1], bx, q[1], q[4], by, q[2], q[5], bz));
+    return true;
+  }
+
+private:
+  double q[10]; // aa, ab, ac, ad, bb, bc, bd, cc, cd, dd
+
+}; // Quadric
+
+
+//////////////////////////////////////////////////////////
+//
+// Collapse: edge collapse
+// ========
+struct Collapse
+{
+  double cost; // including the boundary constraints
+  double error; // of the plane quadrics only
+  int u;
+  int v;
+  int uVersion;
+  int vVersion;
+  vec3 p;
+
+}; // Collapse
+
+
+//////////////////////////////////////////////////////////
+//
+// CollapseHeap: binary min-heap of collapses by cost
+// ============
+class CollapseHeap
+{
+public:
+  // Constructor
+  CollapseHeap(int size):
+    heap(size)
+  {
+    // do nothing
+  }
+
+  bool isEmpty() const
+  {
+    return heap.isEmpty();
+  }
+
+  const Collapse& top() const
+  {
+    return heap[0];
+  }
+
+  void push(const Collapse&);
+  void pop();
+
+private:
+  Array<Collapse> heap;
+
+}; // CollapseHeap
+
+void
+CollapseHeap::push(const Collapse& c)
+{
+  int i = heap.size();
+
+  heap.add(c);
+  // Sift up
+  for (int p; i > 0 && c.cost < heap[p = (i - 1) >> 1].cost; i = p)
+    heap[i] = heap[p];
+  heap[i] = c;
+}
+
+void
+CollapseHeap::pop()
+{
+  int n = heap.size() - 1;
+  Collapse c = heap[n];
+
+  heap.removeAt(n);
+  if (n == 0)
+    return;
+  // Sift down the last collapse from the root
+  for (int i = 0;;)
+  {
+    int j = 2 * i + 1;
+
+    if (j >= n)
+    {
+      heap[i] = c;
+      break;
+    }
+    if (j + 1 < n && heap[j + 1].cost < heap[j].cost)
+      j++;
+    if (!(heap[j].cost < c.cost))
+    {
+      heap[i] = c;
+      break;
+    }
+    heap[i] = heap[j];
+    i = j;
+  }
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// QEMSimplifier: edge-collapse simplifier class
+// =============
+class QEMSimplifier
+{
+public:
+  // Constructor
+  QEMSimplifier(const TriangleMesh&);
+
+  // Destructor
+  ~QEMSimplifier();
+
+  double simplify(int);
+  TriangleMesh* makeMesh() const;
+
+private:
+  const TriangleMesh::Arrays& data;
+  vec3* position;
+  Quadric* quadric; // plane and boundary quadrics
+  Quadric* planes; // plane quadrics
+  Array<int>* vertexTriangles;
+  int* version;
+  bool* alive;
+  TriangleMesh::Triangle* triangles;
+  bool* removed;
+  CollapseHeap heap;
+  int liveTriangles;
+
+  void addCollapse(int, int);
+  bool canCollapse(int, int, const vec3&) const;
+  void collapse(int, int, const vec3&);
+  void neighbors(int, Array<int>&) const;
+
+}; // QEMSimplifier
+
+//
+// Auxiliary functions
+//
+inline bool
+hasVertex(const TriangleMesh::Triangle& t, int v)
+{
+  return t.v[0] == v || t.v[1] == v || t.v[2] == v;
+}
+
+inline vec3
+faceNormal(const vec3& p0, const vec3& p1, const vec3& p2)
+{
+  return (p1 - p0).cross(p2 - p0);
+}
+
+inline void
+truncate(Array<int>& a, int n)
+{
+  while (a.size() > n)
+    a.removeAt(a.size() - 1);
+}
+
+inline void
+sortUnique(Array<int>& a)
+{
+  // Insertion sort, since the neighborhoods are small
+  int* p = a.getData();
+  int n = a.size();
+
+  for (int i = 1; i < n; i++)
+  {
+    int x = p[i];
+    int j = i;
+
+    for (; j > 0 && p[j - 1] > x; j--)
+      p[j] = p[j - 1];
+    p[j] = x;
+  }
+
+  int m = 0;
+
+  for (int i = 0; i < n; i++)
+    if (m == 0 || p[i] != p[m - 1])
+      p[m++] = p[i];
+  truncate(a, m);
+}
+
+QEMSimplifier::QEMSimplifier(const TriangleMesh& mesh):
+  data(mesh.getData()),
+  heap(2 * data.numberOfTriangles),
+  liveTriangles(data.numberOfTriangles)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  int nv = data.numberOfVertices;
+  int nt = liveTriangles;
+
+  position = new vec3[nv];
+  quadric = new Quadric[nv];
+  planes = new Quadric[nv];
+  vertexTriangles = new Array<int>[nv];
+  version = new int[nv];
+  alive = new bool[nv];
+  triangles = new TriangleMesh::Triangle[nt];
+  removed = new bool[nt];
+  for (int v = 0; v < nv; v++)
+  {
+    position[v] = data.vertices[v];
+    version[v] = 0;
+    alive[v] = true;
+  }
+  memcpy(triangles, data.triangles, nt * sizeof(TriangleMesh::Triangle));
+  for (int t = 0; t < nt; t++)
+  {
+    const int* v = triangles[t].v;
+    vec3 N = faceNormal(position[v[0]], position[v[1]], position[v[2]]);
+
+    if (!N.isNull())
+    {
+      N.normalize();
+
+      Quadric Q(N, -N.dot(position[v[0]]));
+
+      for (int k = 0; k < 3; k++)
+        planes[v[k]] += Q;
+    }
+    for (int k = 0; k < 3; k++)
+      vertexTriangles[v[k]].add(t);
+    removed[t] = false;
+  }
+  for (int v = 0; v < nv; v++)
+    quadric[v] = planes[v];
+
+  const TriangleMesh::HalfEdges& edges = mesh.getHalfEdges();
+
+  for (int h = 0; h < edges.numberOfHalfEdges; h++)
+  {
+    int twin = edges.twin(h);
+
+    // Visit each pair of twins once
+    if (twin >= 0 && twin < h)
+      continue;
+
+    int a = edges.origin(h);
+    int b = edges.target(h);
+
+    // Boundary edges are constrained by a plane orthogonal to
+    // their triangle. The constraint steers the collapses, but it
+    // is not a distance to the original surface, so it is kept out
+    // of the error
+    if (twin == TriangleMesh::HalfEdges::Boundary)
+    {
+      const int* v = triangles[TriangleMesh::HalfEdges::face(h)].v;
+      vec3 N = faceNormal(position[v[0]], position[v[1]], position[v[2]]);
+      vec3 E = position[b] - position[a];
+      vec3 B = E.cross(N);
+
+      if (!B.isNull())
+      {
+        B.normalize();
+
+        Quadric Q(B, -B.dot(position[a]), BOUNDARY_WEIGHT);
+
+        quadric[a] += Q;
+        quadric[b] += Q;
+      }
+    }
+    if (a != b)
+      addCollapse(a, b);
+  }
+}
+
+QEMSimplifier::~QEMSimplifier()
+//[]---------------------------------------------------[]
+//|  Destructor                                         |
+//[]---------------------------------------------------[]
+{
+  delete []removed;
+  delete []triangles;
+  delete []alive;
+  delete []version;
+  delete []vertexTriangles;
+  delete []planes;
+  delete []quadric;
+  delete []position;
+}
+
+void
+QEMSimplifier::addCollapse(int u, int v)
+//[]---------------------------------------------------[]
+//|  Add collapse                                       |
+//[]---------------------------------------------------[]
+{
+  Quadric Q = quadric[u] + quadric[v];
+  Collapse c;
+
+  if (!Q.optimize(c.p))
+  {
+    // Choose the best among the end points and the midpoint
+    vec3 m = (position[u] + position[v]) * (REAL)0.5;
+    double cu = Q.evaluate(position[u]);
+    double cv = Q.evaluate(position[v]);
+    double cm = Q.evaluate(m);
+
+    c.p = cu < cv ? (cu < cm ? position[u] : m) : (cv < cm ? position[v] : m);
+  }
+  c.cost = dMax(Q.evaluate(c.p), 0.0);
+  c.error = dMax((planes[u] + planes[v]).evaluate(c.p), 0.0);
+  c.u = u;
+  c.v = v;
+  c.uVersion = version[u];
+  c.vVersion = version[v];
+  heap.push(c);
+}
+
+void
+QEMSimplifier::neighbors(int u, Array<int>& n) const
+{
+  const Array<int>& tu = vertexTriangles[u];
+
+  n.clear();
+  for (int i = 0, nt = tu.size(); i < nt; i++)
+  {
+    int t = tu[i];
+
+    if (!removed[t])
+      for (int k = 0; k < 3; k++)
+        if (triangles[t].v[k] != u)
+          n.add(triangles[t].v[k]);
+  }
+  sortUnique(n);
+}
+
+bool
+QEMSimplifier::canCollapse(int u, int v, const vec3& p) const
+//[]---------------------------------------------------[]
+//|  Can collapse                                       |
+//|                                                     |
+//|  A collapse is rejected if it would make the mesh   |
+//|  non-manifold (link condition) or flip a triangle.  |
+//[]---------------------------------------------------[]
+{
+  Array<int> nu;
+  Array<int> nv;
+  int common = 0;
+  int shared = 0;
+
+  neighbors(u, nu);
+  neighbors(v, nv);
+  // Count the common neighbors by merging the sorted lists
+  for (int i = 0, j = 0; i < nu.size() && j < nv.size();)
+    if (nu[i] < nv[j])
+      i++;
+    else if (nv[j] < nu[i])
+      j++;
+    else
+    {
+      common++;
+      i++;
+      j++;
+    }
+
+  const Array<int>& tu = vertexTriangles[u];
+
+  for (int i = 0, nt = tu.size(); i < nt; i++)
+  {
+    int t = tu[i];
+
+    if (!removed[t] && hasVertex(triangles[t], v))
+      shared++;
+  }
+  if (common > shared)
+    return false;
+  for (int s = 0; s < 2; s++)
+  {
+    int w = s == 0 ? u : v;
+    const Array<int>& vt = vertexTriangles[w];
+
+    for (int i = 0, nt = vt.size(); i < nt; i++)
+    {
+      int t = vt[i];
+
+      if (removed[t] || hasVertex(triangles[t], s == 0 ? v : u))
+        continue;
+
+      const int* tv = triangles[t].v;
+      vec3 q[3];
+
+      for (int k = 0; k < 3; k++)
+        q[k] = tv[k] == w ? p : position[tv[k]];
+
+      vec3 N0 = faceNormal(position[tv[0]], position[tv[1]], position[tv[2]]);
+      vec3 N1 = faceNormal(q[0], q[1], q[2]);
+
+      if (N0.dot(N1) <= 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+void
+QEMSimplifier::collapse(int u, int v, const vec3& p)
+//[]---------------------------------------------------[]
+//|  Collapse v into u                                  |
+//[]---------------------------------------------------[]
+{
+  Array<int>& tu = vertexTriangles[u];
+  Array<int>& tv = vertexTriangles[v];
+
+  position[u] = p;
+  quadric[u] += quadric[v];
+  planes[u] += planes[v];
+  alive[v] = false;
+  version[u]++;
+  for (int i = 0, nt = tv.size(); i < nt; i++)
+  {
+    int t = tv[i];
+
+    if (removed[t])
+      continue;
+
+    int* w = triangles[t].v;
+
+    if (hasVertex(triangles[t], u))
+    {
+      removed[t] = true;
+      liveTriangles--;
+    }
+    else
+    {
+      for (int k = 0; k < 3; k++)
+        if (w[k] == v)
+          w[k] = u;
+      tu.add(t);
+    }
+  }
+  tv.clear();
+
+  // Drop the removed triangles of u
+  int n = 0;
+
+  for (int i = 0, nt = tu.size(); i < nt; i++)
+    if (!removed[tu[i]])
+      tu[n++] = tu[i];
+  truncate(tu, n);
+
+  Array<int> nu;
+
+  neighbors(u, nu);
+  for (int i = 0; i < nu.size(); i++)
+    addCollapse(u, nu[i]);
+}
+
+double
+QEMSimplifier::simplify(int target)
+//[]---------------------------------------------------[]
+//|  Simplify                                           |
+//[]---------------------------------------------------[]
+{
+  double maxError = 0;
+
+  while (liveTriangles > target && !heap.isEmpty())
+  {
+    Collapse c = heap.top();
+
+    heap.pop();
+    if (!alive[c.u] || !alive[c.v])
+      continue;
+    if (c.uVersion != version[c.u] || c.vVersion != version[c.v])
+      continue;
+    if (!canCollapse(c.u, c.v, c.p))
+      continue;
+    collapse(c.u, c.v, c.p);
+    maxError = dMax(maxError, c.error);
+  }
+  return maxError;
+}
+
+TriangleMesh*
+QEMSimplifier::makeMesh() const
+//[]---------------------------------------------------[]
+//|  Make mesh                                          |
+//[]---------------------------------------------------[]
+{
+  int nv = data.numberOfVertices;
+  int nt = data.numberOfTriangles;
+  int* remap = new int[nv];
+  int n = 0;
+
+  // Number the vertices of the remaining triangles
+  memset(remap, -1, nv * sizeof(int));
+  for (int t = 0; t < nt; t++)
+    if (!removed[t])
+      for (int k = 0; k < 3; k++)
+        if (remap[triangles[t].v[k]] < 0)
+          remap[triangles[t].v[k]] = n++;
+
+  // Per-vertex colors are kept by the surviving vertices
+  bool hasColors = data.colors != 0 && data.numberOfColors == nv;
+  TriangleMesh::Block* block =
+    TriangleMesh::Block::New(n, n, liveTriangles, hasColors ? n : 0);
+
+  if (block == 0)
+  {
+    delete []remap;
+    return 0;
+  }
+
+  TriangleMesh::Arrays a = block->getArrays();
+
+  for (int t = 0, i = 0; t < nt; t++)
+    if (!removed[t])
+    {
+      TriangleMesh::Triangle& s = a.triangles[i++];
+
+      for (int k = 0; k < 3; k++)
+        s.v[k] = remap[triangles[t].v[k]];
+    }
+  for (int v = 0; v < nv; v++)
+    if (remap[v] >= 0)
+    {
+      a.vertices[remap[v]] = position[v];
+      if (hasColors)
+        a.colors[remap[v]] = data.colors[v];
+    }
+  delete []remap;
+
+  TriangleMesh* mesh = new TriangleMesh(block);
+
+  mesh->computeNormals();
+  return mesh;
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// MeshSimplifier implementation
+// ==============
+TriangleMesh*
+MeshSimplifier::execute(const TriangleMesh& mesh, int target, REAL* error)
+//[]---------------------------------------------------[]
+//|  Execute                                            |
+//[]---------------------------------------------------[]
+{
+  QEMSimplifier s(mesh);
+  double e = s.simplify(dMax(target, 0));
+
+  if (error != 0)
+    *error = (REAL)sqrt(e);
+  return s.makeMesh();
+}
+
+int
+MeshSimplifier::makeLODs(const TriangleMesh& mesh,
+  const REAL ratios[],
+  int n,
+  TriangleMesh* lods[],
+  REAL errors[])
+//[]---------------------------------------------------[]
+//|  Make LODs                                          |
+//[]---------------------------------------------------[]
+{
+  const TriangleMesh* source = &mesh;
+  int nt = mesh.getData().numberOfTriangles;
+  REAL error = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    REAL e;
+
+    // A LOD that could not be made ends the chain
+    if ((lods[i] = execute(*source, int(nt * ratios[i]), &e)) == 0)
+      return i;
+    errors[i] = error += e;
+    source = lods[i];
+  }
+  return n;
+}
@@ -13,6 +13,8 @@
 //  Source file for mesh sweeper.
 
 #include <stdio.h>
+#include "Math/BatchTransform.h"
+#include "MeshOptimizer.h"
 #include "MeshSweeper.h"
 
 using namespace Graphics;
@@ -36,26 +38,29 @@ MeshSweeper::makeCylinder(
   int nv = np * 2; // number of vertices
   int nb = np - 2; // number of triangles of the base
   int nt = nv + 2 * nb; // number of triangles
-  TriangleMesh::Arrays data;
+  // The normals are computed by the mesh
+  TriangleMesh::Block* block = TriangleMesh::Block::New(nv, nv, nt, 0);
 
-  data.vertices = new vec3[data.numberOfVertices = nv];
-  data.triangles = new TriangleMesh::Triangle[data.numberOfTriangles = nt];
+  if (block == 0)
+    return 0;
 
+  TriangleMesh::Arrays data = block->getArrays();
   vec3 c(0, 0, 0);
 
   if (true)
   {
-    Polyline::VertexIterator vit(circle.getVertexIterator());
+    const Polyline::Vertex* v = circle.getVertices();
 
     for (int i = 0; i < np; i++)
     {
-      const vec3& p = vit++.position;
+      const vec3& p = v[i].position;
 
       c += p;
-      data.vertices[i + np] = m.transform3x4(p);
-      data.vertices[i] = m.transform3x4(p + path);
+      data.vertices[i + np] = p;
+      data.vertices[i] = p + path;
     }
     c *= Math::inverse(REAL(np));
+    transformPoints(m, data.vertices, data.vertices, nv);
   }
 
   TriangleMesh::Triangle* triangle = data.triangles;
@@ -82,7 +87,7 @@ MeshSweeper::makeCylinder(
     v2 = ((v1 = (v0 = v2) + 1) + 1) % np;
   }
 
-  TriangleMesh* mesh = new TriangleMesh(data);
+  TriangleMesh* mesh = new TriangleMesh(block);
 
   mesh->computeNormals();
   return mesh;
@@ -167,11 +172,13 @@ MeshSweeper::makeSphere(const vec3& center, REAL radius, int mers)
   int sections = mers;
   int nv = sections * mers + 2; // number of vertices (and normals)
   int nt = 2 * mers * sections; // number of triangles
-  TriangleMesh::Arrays data;
+  TriangleMesh::Block* block = TriangleMesh::Block::New(nv, nv, nt, 0);
+
+  if (block == 0)
+    return 0;
+
+  TriangleMesh::Arrays data = block->getArrays();
 
-  data.vertices = new vec3[data.numberOfVertices = nv];
-  data.normals = new vec3[data.numberOfNormals = nv];
-  data.triangles = new TriangleMesh::Triangle[data.numberOfTriangles = nt];
   {
     Polyline arc = makeArc(center, radius, vec3(0, 0, 1), 180, sections + 1);
     Polyline::VertexIterator vit = arc.getVertexIterator();
@@ -232,5 +239,7 @@ MeshSweeper::makeSphere(const vec3& center, REAL radius, int mers)
     triangle->setVertices(i, j, k);
     triangle++;
   }
-  return new TriangleMesh(data);
+  // Replace the fan/strip order above by a vertex cache friendly one
+  MeshOptimizer::execute(data);
+  return new TriangleMesh(block);
 }
@@ -0,0 +1,373 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: OcclusionCuller.cpp
+//  ========
+//  Source file for HiZ occlusion culler.
+
+#include <float.h>
+#include <math.h>
+#include "Math/SIMD.h"
+#include "OcclusionCuller.h"
+
+using namespace Graphics;
+
+// Rows of the depth buffer rasterized by each thread
+#define BAND_HEIGHT 16
+// Levels with fewer texels are built sequentially
+#define MIN_PARALLEL_LEVEL 4096
+
+
+//////////////////////////////////////////////////////////
+//
+// OcclusionCuller implementation
+// ===============
+OcclusionCuller::OcclusionCuller(int width, int height):
+  numberOfLevels(0)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  setSize(width, height);
+}
+
+OcclusionCuller::~OcclusionCuller()
+//[]---------------------------------------------------[]
+//|  Destructor                                         |
+//[]---------------------------------------------------[]
+{
+  freeLevels();
+}
+
+void
+OcclusionCuller::freeLevels()
+//[]---------------------------------------------------[]
+//|  Free levels                                        |
+//[]---------------------------------------------------[]
+{
+  for (int i = 0; i < numberOfLevels; i++)
+    delete []levels[i];
+  numberOfLevels = 0;
+}
+
+void
+OcclusionCuller::setSize(int width, int height)
+//[]---------------------------------------------------[]
+//|  Set size                                           |
+//[]---------------------------------------------------[]
+{
+  freeLevels();
+  width = dMax<int>(width, 1);
+  height = dMax<int>(height, 1);
+  for (;;)
+  {
+    int i = numberOfLevels++;
+
+    widths[i] = width;
+    heights[i] = height;
+    // The rows of the depth buffer are padded to a multiple of
+    // four texels, which are rasterized together
+    strides[i] = i == 0 ? (width + 3) & ~3 : width;
+    levels[i] = new float[strides[i] * height];
+    for (int j = strides[i] * height; j-- > 0;)
+      levels[i][j] = 1;
+    if ((width == 1 && height == 1) || numberOfLevels == MAX_OCCLUSION_LEVELS)
+      break;
+    width = (width + 1) >> 1;
+    height = (height + 1) >> 1;
+  }
+}
+
+inline OcclusionCuller::Vertex
+OcclusionCuller::project(const mat4& m, const vec3& p, int width, int height)
+//[]---------------------------------------------------[]
+//|  Project                                            |
+//[]---------------------------------------------------[]
+{
+  vec4 c = m.transform(vec4(p, 1));
+  Vertex v;
+
+  v.clipped = c.w <= 0 || c.z < -c.w;
+  if (!v.clipped)
+  {
+    REAL s = Math::inverse<REAL>(c.w);
+
+    v.x = float((c.x * s + 1) * 0.5 * width);
+    v.y = float((c.y * s + 1) * 0.5 * height);
+    v.z = float((c.z * s + 1) * 0.5);
+  }
+  return v;
+}
+
+void
+OcclusionCuller::begin(const mat4& m)
+//[]---------------------------------------------------[]
+//|  Begin                                              |
+//[]---------------------------------------------------[]
+{
+  vpMatrix = m;
+  triangles.clear();
+  for (int i = strides[0] * heights[0]; i-- > 0;)
+    levels[0][i] = 1;
+}
+
+void
+OcclusionCuller::addOccluder(const TriangleMesh& mesh, const mat4& matrix)
+//[]---------------------------------------------------[]
+//|  Add occluder                                       |
+//|                                                     |
+//|  The vertices are projected once; the triangles     |
+//|  facing either side are kept in screen space and    |
+//|  wound counterclockwise.                            |
+//[]---------------------------------------------------[]
+{
+  const TriangleMesh::Arrays& data = mesh.getData();
+  mat4 m = vpMatrix * matrix;
+  int w = widths[0];
+  int h = heights[0];
+
+  vertices.clear();
+  vertices.reserve(data.numberOfVertices);
+  for (int i = 0; i < data.numberOfVertices; i++)
+    vertices.add(project(m, data.vertices[i], w, h));
+  for (int i = 0; i < data.numberOfTriangles; i++)
+  {
+    const int* v = data.triangles[i].v;
+    Triangle t;
+
+    t.v[0] = vertices[v[0]];
+    t.v[1] = vertices[v[1]];
+    t.v[2] = vertices[v[2]];
+    if (t.v[0].clipped || t.v[1].clipped || t.v[2].clipped)
+      continue;
+
+    const Vertex& a = t.v[0];
+    float area = (t.v[1].x - a.x) * (t.v[2].y - a.y) -
+      (t.v[1].y - a.y) * (t.v[2].x - a.x);
+
+    if (area == 0)
+      continue;
+    if (area < 0)
+      std::swap(t.v[1], t.v[2]);
+
+    float xMin = dMin(dMin(a.x, t.v[1].x), t.v[2].x);
+    float xMax = dMax(dMax(a.x, t.v[1].x), t.v[2].x);
+    float yMin = dMin(dMin(a.y, t.v[1].y), t.v[2].y);
+    float yMax = dMax(dMax(a.y, t.v[1].y), t.v[2].y);
+
+    if (xMax < 0 || yMax < 0 || xMin >= w || yMin >= h)
+      continue;
+    t.yMin = dMax<int>((int)floorf(dMax(yMin, 0.0f)), 0);
+    t.yMax = dMin<int>((int)floorf(dMin(yMax, float(h))), h - 1);
+    triangles.add(t);
+  }
+}
+
+void
+OcclusionCuller::rasterize(const Triangle& t, int y0, int y1)
+//[]---------------------------------------------------[]
+//|  Rasterize                                          |
+//|                                                     |
+//|  Texels whose centers are inside the triangle keep  |
+//|  the nearest depth, taken as the farthest depth of  |
+//|  the triangle plane over the texel. The edge        |
+//|  functions and depth are evaluated for four texels  |
+//|  at a time.                                         |
+//[]---------------------------------------------------[]
+{
+  const Vertex& a = t.v[0];
+  const Vertex& b = t.v[1];
+  const Vertex& c = t.v[2];
+  // Edge functions e(x, y) = A * x + B * y + C, positive inside
+  const float A0 = a.y - b.y, B0 = b.x - a.x, C0 = a.x * b.y - a.y * b.x;
+  const float A1 = b.y - c.y, B1 = c.x - b.x, C1 = b.x * c.y - b.y * c.x;
+  const float A2 = c.y - a.y, B2 = a.x - c.x, C2 = c.x * a.y - c.y * a.x;
+  const float area = C0 + C1 + C2;
+  // The depth is interpolated by the barycentric coordinates
+  const float s = 1 / area;
+  const float zA = (A1 * a.z + A2 * b.z + A0 * c.z) * s;
+  const float zB = (B1 * a.z + B2 * b.z + B0 * c.z) * s;
+  const float zC = (C1 * a.z + C2 * b.z + C0 * c.z) * s +
+    (fabsf(zA) + fabsf(zB)) * 0.5f;
+  const int w = widths[0];
+  const int stride = strides[0];
+  int x0 = (int)floorf(dMax(dMin(dMin(a.x, b.x), c.x), 0.0f));
+  int x1 = (int)floorf(dMin(dMax(dMax(a.x, b.x), c.x), float(w)));
+
+  x0 &= ~3;
+  x1 = dMin<int>(x1, w - 1);
+  for (int y = y0; y <= y1; y++)
+  {
+    const float py = y + 0.5f;
+    float* row = levels[0] + y * stride;
+#ifdef DS_SIMD_SSE
+    const __m128 e0 = _mm_set1_ps(B0 * py + C0);
+    const __m128 e1 = _mm_set1_ps(B1 * py + C1);
+    const __m128 e2 = _mm_set1_ps(B2 * py + C2);
+    const __m128 z0 = _mm_set1_ps(zB * py + zC);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 px = _mm_add_ps(_mm_set1_ps(float(x0)),
+      _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+
+    for (int x = x0; x <= x1; x += 4)
+    {
+      __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(A0),
+        px), e0), zero);
+
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(
+        _mm_set1_ps(A1), px), e1), zero));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(
+        _mm_set1_ps(A2), px), e2), zero));
+      if (_mm_movemask_ps(inside) != 0)
+      {
+        const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), z0);
+        const __m128 d = _mm_loadu_ps(row + x);
+
+        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside,
+          _mm_min_ps(d, z)),
+          _mm_andnot_ps(inside, d)));
+      }
+      px = _mm_add_ps(px, _mm_set1_ps(4));
+    }
+#else
+    for (int x = x0; x <= x1; x++)
+    {
+      const float px = x + 0.5f;
+
+      if (A0 * px + B0 * py + C0 >= 0 &&
+        A1 * px + B1 * py + C1 >= 0 &&
+        A2 * px + B2 * py + C2 >= 0)
+        row[x] = dMin(row[x], zA * px + zB * py + zC);
+    }
+#endif // DS_SIMD_SSE
+  }
+}
+
+void
+OcclusionCuller::buildPyramid()
+//[]---------------------------------------------------[]
+//|  Build pyramid                                      |
+//[]---------------------------------------------------[]
+{
+  for (int k = 1; k < numberOfLevels; k++)
+  {
+    const float* src = levels[k - 1];
+    const int sw = widths[k - 1];
+    const int sh = heights[k - 1];
+    const int ss = strides[k - 1];
+    float* dst = levels[k];
+    const int w = widths[k];
+    const int h = heights[k];
+
+    // Odd sizes repeat the last row and column of the level below
+#pragma omp parallel for if (w * h >= MIN_PARALLEL_LEVEL)
+    for (int y = 0; y < h; y++)
+    {
+      const float* r0 = src + 2 * y * ss;
+      const float* r1 = src + dMin<int>(2 * y + 1, sh - 1) * ss;
+
+      for (int x = 0; x < w; x++)
+      {
+        const int x0 = 2 * x;
+        const int x1 = dMin<int>(x0 + 1, sw - 1);
+
+        dst[y * w + x] = dMax(dMax(r0[x0], r0[x1]), dMax(r1[x0], r1[x1]));
+      }
+    }
+  }
+}
+
+void
+OcclusionCuller::end()
+//[]---------------------------------------------------[]
+//|  End                                                |
+//|                                                     |
+//|  Each thread rasterizes all the triangles crossing  |
+//|  a band of rows of the depth buffer.                |
+//[]---------------------------------------------------[]
+{
+  const int h = heights[0];
+  const int bands = (h + BAND_HEIGHT - 1) / BAND_HEIGHT;
+  const int n = triangles.size();
+
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < bands; i++)
+  {
+    const int y0 = i * BAND_HEIGHT;
+    const int y1 = dMin<int>(y0 + BAND_HEIGHT, h) - 1;
+
+    for (int j = 0; j < n; j++)
+    {
+      const Triangle& t = triangles[j];
+
+      if (t.yMax >= y0 && t.yMin <= y1)
+        rasterize(t, dMax<int>(t.yMin, y0), dMin<int>(t.yMax, y1));
+    }
+  }
+  buildPyramid();
+}
+
+bool
+OcclusionCuller::isOccluded(const Bounds3& box) const
+//[]---------------------------------------------------[]
+//|  Is occluded                                        |
+//|                                                     |
+//|  The screen rectangle of the box is tested at the   |
+//|  finest level where it covers at most 2x2 texels.   |
+//[]---------------------------------------------------[]
+{
+  if (box.isEmpty())
+    return false;
+
+  const vec3& p1 = box.getMin();
+  const vec3& p2 = box.getMax();
+  const int w = widths[0];
+  const int h = heights[0];
+  float xMin = FLT_MAX, xMax = -FLT_MAX;
+  float yMin = FLT_MAX, yMax = -FLT_MAX;
+  float zMin = FLT_MAX;
+
+  for (int i = 0; i < 8; i++)
+  {
+    vec3 p(i & 1 ? p2.x : p1.x, i & 2 ? p2.y : p1.y, i & 4 ? p2.z : p1.z);
+    Vertex v = project(vpMatrix, p, w, h);
+
+    if (v.clipped)
+      return false;
+    xMin = dMin(xMin, v.x);
+    xMax = dMax(xMax, v.x);
+    yMin = dMin(yMin, v.y);
+    yMax = dMax(yMax, v.y);
+    zMin = dMin(zMin, v.z);
+  }
+  // Boxes outside the window are left to the frustum culling
+  if (xMax < 0 || yMax < 0 || xMin >= w || yMin >= h)
+    return false;
+
+  int x0 = (int)floorf(dMax(xMin, 0.0f));
+  int x1 = dMin<int>((int)floorf(xMax), w - 1);
+  int y0 = (int)floorf(dMax(yMin, 0.0f));
+  int y1 = dMin<int>((int)floorf(yMax), h - 1);
+  int level = 0;
+
+  while (level < numberOfLevels - 1 && (x1 - x0 > 1 || y1 - y0 > 1))
+  {
+    x0 >>= 1;
+    x1 >>= 1;
+    y0 >>= 1;
+    y1 >>= 1;
+    level++;
+  }
+  for (int y = y0; y <= y1; y++)
+    for (int x = x0; x <= x1; x++)
+      if (zMin <= levels[level][y * strides[level] + x])
+        return false;
+  return true;
+}
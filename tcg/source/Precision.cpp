@@ -0,0 +1,44 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: Precision.cpp
+//  ========
+//  Explicit instantiations of the math and geometry classes.
+//
+//  REAL sets the default precision only; both the float and the double
+//  classes are compiled here, so that any of them can be used in the
+//  same program (e.g., float meshes and double camera matrices).
+
+#include "Geometry/Bounds3.h"
+
+DS_BEGIN_NAMESPACE
+
+template class Vector3<float>;
+template class Vector3<double>;
+template class Vector4<float>;
+template class Vector4<double>;
+template class Quaternion<float>;
+template class Quaternion<double>;
+template class Matrix3x3<float>;
+template class Matrix3x3<double>;
+template class Matrix4x4<float>;
+template class Matrix4x4<double>;
+
+namespace Geometry
+{ // begin namespace Geometry
+
+template class Ray3<float>;
+template class Ray3<double>;
+template class BoundingBox3<float>;
+template class BoundingBox3<double>;
+
+} // end namespace Geometry
+
+DS_END_NAMESPACE
@@ -106,4 +106,5 @@ Renderer::update()
 //[]---------------------------------------------------[]
 {
   camera->updateView();
+  scene->update();
 }
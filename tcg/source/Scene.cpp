@@ -53,6 +53,16 @@ Scene::findActor(Model* model) const
   return 0;
 }
 
+Actor*
+Scene::pickActor(const Ray& ray, REAL& distance) const
+//[]---------------------------------------------------[]
+//|  Pick actor                                         |
+//[]---------------------------------------------------[]
+{
+  int row = actorTable.pick(ray, distance);
+  return row < 0 ? 0 : actorTable.getActor(row);
+}
+
 void
 Scene::addActor(Actor* actor)
 //[]---------------------------------------------------[]
@@ -64,11 +74,20 @@ Scene::addActor(Actor* actor)
     actors.add(actor);
     actor->scene = this;
     System::makeUse(actor);
-    if (!modifiedBounds)
-      bounds.inflate(actor->model->boundingBox());
+    actorTable.add(actor);
   }
 }
 
+void
+Scene::updateActor(Actor* actor)
+//[]---------------------------------------------------[]
+//|  Update actor                                       |
+//[]---------------------------------------------------[]
+{
+  if (actor != 0 && actor->getScene() == this)
+    actorTable.invalidate(actor->index);
+}
+
 void
 Scene::deleteActor(Actor* actor)
 //[]---------------------------------------------------[]
@@ -77,10 +96,10 @@ Scene::deleteActor(Actor* actor)
 {
   if (actor != 0 && actor->getScene() == this)
   {
+    actorTable.remove(actor);
     actors.remove(*actor);
     actor->scene = 0;
     actor->release();
-    modifiedBounds = true;
   }
 }
 
@@ -118,14 +137,13 @@ Scene::deleteActors()
 //|  Delete all actors                                  |
 //[]---------------------------------------------------[]
 {
+  actorTable.clear();
   for (Actor* actor; (actor = actors.peekHead()) != 0;)
   {
     actors.remove(*actor);
     actor->scene = 0;
     actor->release();
   }
-  bounds.setEmpty();
-  modifiedBounds = false;
 }
 
 void
@@ -142,21 +160,56 @@ Scene::deleteLights()
   }
 }
 
-inline void
-Scene::updateBounds()
+int
+Scene::update()
+//[]---------------------------------------------------[]
+//|  Update                                             |
+//[]---------------------------------------------------[]
 {
-  bounds.setEmpty();
-  for (Actor* actor = actors.peekHead(); actor != 0; actor = actor->next)
-    bounds.inflate(actor->model->boundingBox());
+  return actorTable.update();
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// Model implementation
+// =====
+void
+Model::modified()
+//[]---------------------------------------------------[]
+//|  Modified                                           |
+//[]---------------------------------------------------[]
+{
+  timestamp++;
+  for (int i = 0, n = actors.size(); i < n; i++)
+    actors[i]->modified();
+}
+
+
+//////////////////////////////////////////////////////////
+//
+// Actor implementation
+// =====
+void
+Actor::modified()
+//[]---------------------------------------------------[]
+//|  Modified                                           |
+//[]---------------------------------------------------[]
+{
+  if (scene != 0)
+    scene->updateActor(this);
 }
 
-const Bounds3&
-Scene::boundingBox()
+bool
+Actor::setParent(Actor* actor)
 //[]---------------------------------------------------[]
-//|  Bounding box                                       |
+//|  Set parent                                         |
 //[]---------------------------------------------------[]
 {
-  if (modifiedBounds)
-    updateBounds();
-  return bounds;
+  for (Actor* a = actor; a != 0; a = a->parent)
+    if (a == this)
+      return false;
+  parent = actor;
+  modified();
+  return true;
 }
@@ -13,6 +13,7 @@
 //  Source file for generic sweeper.
 
 #include "Sweeper.h"
+#include "Math/BatchTransform.h"
 
 using namespace Graphics;
 
@@ -27,8 +28,12 @@ Sweeper::Polyline::transform(const mat4& m)
 //|  Transform                                           |
 //[]----------------------------------------------------[]
 {
-  for (VertexIterator vit(getVertexIterator()); vit;)
-    (vit++).transform(m);
+  // A vertex is just its position
+  static_assert(sizeof(Vertex) == sizeof(vec3), "Vertex is not a vec3");
+
+  vec3* p = &data->vertices.getData()->position;
+
+  transformPoints(m, p, p, getNumberOfVertices());
 }
 
 vec3
@@ -37,24 +42,23 @@ Sweeper::Polyline::normal() const
 //|  Normal                                              |
 //[]----------------------------------------------------[]
 {
-  vec3 N(0, 0, 0);
-  VertexIterator vit(getVertexIterator());
-
-  if (vit)
+  const Vertex* v = getVertices();
+  int n = getNumberOfVertices();
+  REAL x = 0;
+  REAL y = 0;
+  REAL z = 0;
+
+  // Newell's method: the last vertex is followed by the first one
+  for (int i = n - 1, j = 0; j < n; i = j++)
   {
-    vec3* first = &(vit++).position;
-    vec3* p = first;
-
-    for (vec3* q = 0; q != first;)
-    {
-      q = vit ? &(vit++).position : first;
-      N.x += (p->y - q->y) * (p->z + q->z);
-      N.y += (p->z - q->z) * (p->x + q->x);
-      N.z += (p->x - q->x) * (p->y + q->y);
-      p = q;
-    }
+    const vec3& p = v[i].position;
+    const vec3& q = v[j].position;
+
+    x += (p.y - q.y) * (p.z + q.z);
+    y += (p.z - q.z) * (p.x + q.x);
+    z += (p.x - q.x) * (p.y + q.y);
   }
-  return N;
+  return vec3(x, y, z);
 }
 
 //
@@ -104,6 +108,7 @@ Sweeper::makeArc(
   mat4 m = mat4::rotation(normal, REAL(angle / segments), center);
   vec3 p = getFirstPoint(center, radius, normal);
 
+  poly.reserve(segments + 1);
   poly.mv(p);
   for (int i = 1; i <= segments; i++)
   {
@@ -127,6 +132,7 @@ Sweeper::makeCircle(
   mat4 m = mat4::rotation(normal, REAL(360) / points, center);
   vec3 p = getFirstPoint(center, radius, normal);
 
+  poly.reserve(points);
   poly.mv(p);
   for (int i = 1; i < points; i++)
   {
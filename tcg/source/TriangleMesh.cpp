@@ -12,7 +12,13 @@
 //  ========
 //  Source file for simple triangle mesh.
 
+#include <math.h>
 #include <memory.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include "Math/BatchTransform.h"
 #include "TriangleMesh.h"
 
 //
@@ -35,8 +41,27 @@ copyNewArray(T*& dst, const T* src, int n)
 using namespace Graphics;
 
 //
-// Auxiliary function
+// Auxiliary functions
 //
+template <typename T>
+inline ArrayBuffer<T>*
+newBuffer(T* a)
+{
+  return a != 0 ? new ArrayBuffer<T>(a) : 0;
+}
+
+template <typename T>
+inline T*
+makeUnique(ObjectPtr<ArrayBuffer<T> >& buffer, T*& a, int n)
+{
+  if (a != 0 && buffer->getNumberOfUses() > 1)
+  {
+    copyNewArray(a, buffer->data, n);
+    buffer = new ArrayBuffer<T>(a);
+  }
+  return a;
+}
+
 inline void
 printVec3(FILE*f, const char* s, const vec3& p)
 {
@@ -79,53 +104,1116 @@ TriangleMesh::Arrays::copy() const
   return c;
 }
 
+TriangleMesh::TriangleMesh(const Arrays& aData):
+  data(aData),
+  vertexBuffer(newBuffer(aData.vertices)),
+  normalBuffer(newBuffer(aData.normals)),
+  triangleBuffer(newBuffer(aData.triangles)),
+  colorBuffer(newBuffer(aData.colors))
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  // do nothing
+}
+
+TriangleMesh::TriangleMesh(const TriangleMesh& mesh):
+  Object(),
+  userData(mesh.userData),
+  data(mesh.data),
+  vertexBuffer(mesh.vertexBuffer),
+  normalBuffer(mesh.normalBuffer),
+  triangleBuffer(mesh.triangleBuffer),
+  colorBuffer(mesh.colorBuffer),
+  meshlets(mesh.meshlets),
+  halfEdges(mesh.halfEdges),
+  streams(mesh.streams)
+//[]---------------------------------------------------[]
+//|  Copy constructor                                   |
+//|                                                     |
+//|  The arrays, the meshlets, the half-edges, the      |
+//|  vertex streams and the GL vertex arrays (user      |
+//|  data) are shared until the copy is edited.         |
+//[]---------------------------------------------------[]
+{
+  // do nothing
+}
+
+//
+// Auxiliary functions
+//
+inline void*
+alignedAlloc(size_t size)
+{
+#ifdef _WIN32
+  return _aligned_malloc(size, MESH_BLOCK_ALIGNMENT);
+#else
+  void* p;
+
+  return posix_memalign(&p, MESH_BLOCK_ALIGNMENT, size) == 0 ? p : 0;
+#endif
+}
+
+inline void
+alignedFree(void* p)
+{
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+inline int64
+alignedSize(int64 size)
+{
+  return (size + MESH_BLOCK_ALIGNMENT - 1) & ~int64(MESH_BLOCK_ALIGNMENT - 1);
+}
+
+#define MESH_BLOCK_MAGIC   "TCGM"
+#define MESH_BLOCK_VERSION 1
+
+//
+// Mesh block layout: the header is followed by the vertices,
+// normals, triangles and colors, in this order; offsets are from
+// the beginning of the block, and an empty array has offset 0.
+//
+struct TriangleMesh::Block::Header
+{
+  char magic[4];
+  int version;
+  int realSize;
+  int counts[4]; // vertices, normals, triangles and colors
+  int64 offsets[4];
+  int64 size;
+
+}; // TriangleMesh::Block::Header
+
+TriangleMesh::Block::Block(Header* aHeader):
+  header(aHeader)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  // do nothing
+}
+
+TriangleMesh::Block::~Block()
+//[]---------------------------------------------------[]
+//|  Destructor                                         |
+//[]---------------------------------------------------[]
+{
+  alignedFree(header);
+}
+
+TriangleMesh::Block*
+TriangleMesh::Block::New(int nv, int nn, int nt, int nc)
+//[]---------------------------------------------------[]
+//|  New block                                          |
+//[]---------------------------------------------------[]
+{
+  const int64 sizes[4] =
+  {
+    (int64)sizeof(vec3),
+    (int64)sizeof(vec3),
+    (int64)sizeof(Triangle),
+    (int64)sizeof(Color)
+  };
+  const int counts[4] = {nv, nn, nt, nc};
+  Header h;
+  int64 size = alignedSize(sizeof(Header));
+
+  memcpy(h.magic, MESH_BLOCK_MAGIC, 4);
+  h.version = MESH_BLOCK_VERSION;
+  h.realSize = sizeof(REAL);
+  for (int i = 0; i < 4; i++)
+  {
+    h.counts[i] = dMax(counts[i], 0);
+    h.offsets[i] = h.counts[i] != 0 ? size : 0;
+    size += alignedSize(h.counts[i] * sizes[i]);
+  }
+  h.size = size;
+
+  Header* header = (Header*)alignedAlloc((size_t)size);
+
+  if (header == 0)
+    return 0;
+  *header = h;
+  return new Block(header);
+}
+
+TriangleMesh::Block*
+TriangleMesh::Block::read(FILE* file)
+//[]---------------------------------------------------[]
+//|  Read block                                         |
+//[]---------------------------------------------------[]
+{
+  Header h;
+
+  if (fread(&h, sizeof(Header), 1, file) != 1)
+    return 0;
+  if (memcmp(h.magic, MESH_BLOCK_MAGIC, 4) != 0 ||
+    h.version != MESH_BLOCK_VERSION ||
+    h.realSize != sizeof(REAL))
+    return 0;
+
+  Block* block = New(h.counts[0], h.counts[1], h.counts[2], h.counts[3]);
+
+  if (block == 0)
+    return 0;
+  if (block->header->size != h.size)
+  {
+    delete block;
+    return 0;
+  }
+
+  // The rest of the block is read in a single call
+  size_t n = size_t(h.size - sizeof(Header));
+
+  if (fread(block->header + 1, 1, n, file) != n)
+  {
+    delete block;
+    return 0;
+  }
+  return block;
+}
+
+bool
+TriangleMesh::Block::write(FILE* file) const
+//[]---------------------------------------------------[]
+//|  Write block                                        |
+//[]---------------------------------------------------[]
+{
+  return fwrite(header, (size_t)header->size, 1, file) == 1;
+}
+
+TriangleMesh::Arrays
+TriangleMesh::Block::getArrays() const
+//[]---------------------------------------------------[]
+//|  Get arrays                                         |
+//[]---------------------------------------------------[]
+{
+  char* base = (char*)header;
+  const int64* o = header->offsets;
+  Arrays a;
+
+  if ((a.numberOfVertices = header->counts[0]) != 0)
+    a.vertices = (vec3*)(base + o[0]);
+  if ((a.numberOfNormals = header->counts[1]) != 0)
+    a.normals = (vec3*)(base + o[1]);
+  if ((a.numberOfTriangles = header->counts[2]) != 0)
+    a.triangles = (Triangle*)(base + o[2]);
+  if ((a.numberOfColors = header->counts[3]) != 0)
+    a.colors = (Color*)(base + o[3]);
+  return a;
+}
+
+int64
+TriangleMesh::Block::getSize() const
+//[]---------------------------------------------------[]
+//|  Get size                                           |
+//[]---------------------------------------------------[]
+{
+  return header->size;
+}
+
+template <typename T>
+inline ArrayBuffer<T>*
+blockBuffer(T* a, Object* block)
+{
+  return a != 0 ? new ArrayBuffer<T>(a, block) : 0;
+}
+
+TriangleMesh::TriangleMesh(Block* block):
+  data(block->getArrays()),
+  vertexBuffer(blockBuffer(data.vertices, block)),
+  normalBuffer(blockBuffer(data.normals, block)),
+  triangleBuffer(blockBuffer(data.triangles, block)),
+  colorBuffer(blockBuffer(data.colors, block))
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//|                                                     |
+//|  The arrays are views into the block; the block is  |
+//|  released when the last of them is released.        |
+//[]---------------------------------------------------[]
+{
+  if (block->getNumberOfUses() == 0)
+    delete block;
+}
+
 Object*
 TriangleMesh::clone() const
+//[]---------------------------------------------------[]
+//|  Make copy                                          |
+//[]---------------------------------------------------[]
 {
-  return new TriangleMesh(data.copy());
+  return new TriangleMesh(*this);
+}
+
+vec3*
+TriangleMesh::editVertices()
+//[]---------------------------------------------------[]
+//|  Edit vertices                                      |
+//[]---------------------------------------------------[]
+{
+  userData = 0;
+  meshlets = 0;
+  streams = 0;
+  return makeUnique(vertexBuffer, data.vertices, data.numberOfVertices);
+}
+
+vec3*
+TriangleMesh::editNormals()
+//[]---------------------------------------------------[]
+//|  Edit normals                                       |
+//[]---------------------------------------------------[]
+{
+  userData = 0;
+  return makeUnique(normalBuffer, data.normals, data.numberOfNormals);
+}
+
+TriangleMesh::Triangle*
+TriangleMesh::editTriangles()
+//[]---------------------------------------------------[]
+//|  Edit triangles                                     |
+//[]---------------------------------------------------[]
+{
+  userData = 0;
+  meshlets = 0;
+  halfEdges = 0;
+  return makeUnique(triangleBuffer, data.triangles, data.numberOfTriangles);
+}
+
+Color*
+TriangleMesh::editColors()
+//[]---------------------------------------------------[]
+//|  Edit colors                                        |
+//[]---------------------------------------------------[]
+{
+  userData = 0;
+  return makeUnique(colorBuffer, data.colors, data.numberOfColors);
+}
+
+//
+// Auxiliary function
+//
+inline void
+streamRange(const REAL* s, int n, REAL& a, REAL& b)
+{
+  REAL lo = s[0];
+  REAL hi = s[0];
+
+  for (int i = 1; i < n; i++)
+  {
+    lo = s[i] < lo ? s[i] : lo;
+    hi = s[i] > hi ? s[i] : hi;
+  }
+  a = lo;
+  b = hi;
 }
 
 Bounds3
 TriangleMesh::boundingBox() const
+//[]---------------------------------------------------[]
+//|  Bounding box                                       |
+//[]---------------------------------------------------[]
 {
   Bounds3 box;
 
-  for (int i = 0; i < data.numberOfVertices; i++)
-    box.inflate(data.vertices[i]);
+  if (streams != 0 && streams->numberOfVertices != 0)
+  {
+    // One min/max reduction per stream (the padding
+    // replicates the last vertex)
+    vec3 p1;
+    vec3 p2;
+
+    streamRange(streams->x, streams->size, p1.x, p2.x);
+    streamRange(streams->y, streams->size, p1.y, p2.y);
+    streamRange(streams->z, streams->size, p1.z, p2.z);
+    box.set(p1, p2);
+  }
+  else
+    for (int i = 0; i < data.numberOfVertices; i++)
+      box.inflate(data.vertices[i]);
   return box;
 }
 
+TriangleMesh::VertexStreams::VertexStreams(const Arrays& data):
+  numberOfVertices(data.numberOfVertices)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  int n = numberOfVertices;
+
+  size = (n + VERTEX_STREAM_PADDING - 1) & ~(VERTEX_STREAM_PADDING - 1);
+  x = (REAL*)alignedAlloc(dMax(3 * size, 1) * sizeof(REAL));
+  y = x + size;
+  z = y + size;
+
+  const vec3* p = data.vertices;
+
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = p[i].x;
+    y[i] = p[i].y;
+    z[i] = p[i].z;
+  }
+  for (int i = n; i < size; i++)
+  {
+    x[i] = x[n - 1];
+    y[i] = y[n - 1];
+    z[i] = z[n - 1];
+  }
+}
+
+TriangleMesh::VertexStreams::~VertexStreams()
+//[]---------------------------------------------------[]
+//|  Destructor                                         |
+//[]---------------------------------------------------[]
+{
+  alignedFree(x);
+}
+
+const TriangleMesh::VertexStreams&
+TriangleMesh::getVertexStreams() const
+//[]---------------------------------------------------[]
+//|  Vertex streams                                     |
+//[]---------------------------------------------------[]
+{
+  if (streams == 0)
+    streams = new VertexStreams(data);
+  return *streams;
+}
+
+TriangleMesh::VertexTriangles::VertexTriangles(const Arrays& data)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//[]---------------------------------------------------[]
+{
+  int nv = data.numberOfVertices;
+  int nc = 3 * data.numberOfTriangles;
+  const int* v = nc != 0 ? data.triangles->v : 0;
+
+  offsets = new int[nv + 1];
+  corners = new int[nc];
+  memset(offsets, 0, (nv + 1) * sizeof(int));
+  // Count the corners of each vertex...
+  for (int c = 0; c < nc; c++)
+    offsets[v[c] + 1]++;
+  for (int i = 0; i < nv; i++)
+    offsets[i + 1] += offsets[i];
+
+  // ...and fill the corner lists in increasing corner order
+  int* next = new int[nv];
+
+  memcpy(next, offsets, nv * sizeof(int));
+  for (int c = 0; c < nc; c++)
+    corners[next[v[c]]++] = c;
+  delete []next;
+}
+
+//
+// Auxiliary functions
+//
+inline unsigned int
+edgeHash(int a, int b)
+{
+  unsigned int h = (unsigned int)a * 0x9e3779b1u ^ (unsigned int)b * 0x85ebca6bu;
+
+  return h ^ (h >> 16);
+}
+
+TriangleMesh::HalfEdges::HalfEdges(const Arrays& data):
+  numberOfHalfEdges(3 * data.numberOfTriangles),
+  numberOfVertices(data.numberOfVertices),
+  numberOfBoundaryEdges(0),
+  numberOfNonManifoldEdges(0),
+  numberOfNonManifoldVertices(0),
+  triangles(data.triangles)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//|                                                     |
+//|  The half-edges are paired in linear time by an     |
+//|  open addressing hash table of directed edges.      |
+//[]---------------------------------------------------[]
+{
+  int nh = numberOfHalfEdges;
+  int nv = numberOfVertices;
+  unsigned int mask = 15;
+
+  while (mask < 2u * nh)
+    mask = 2 * mask + 1;
+
+  int* table = new int[mask + 1];
+
+  twins = new int[nh];
+  memset(table, -1, (mask + 1) * sizeof(int));
+  // Insert the directed edges; repeated ones are non-manifold
+  for (int h = 0; h < nh; h++)
+  {
+    int a = origin(h);
+    int b = target(h);
+
+    twins[h] = Boundary;
+    if (a == b)
+    {
+      twins[h] = NonManifold;
+      continue;
+    }
+    for (unsigned int i = edgeHash(a, b) & mask;; i = (i + 1) & mask)
+    {
+      int g = table[i];
+
+      if (g < 0)
+      {
+        table[i] = h;
+        break;
+      }
+      if (origin(g) == a && target(g) == b)
+      {
+        twins[g] = twins[h] = NonManifold;
+        break;
+      }
+    }
+  }
+  // Pair each half-edge with the opposite directed edge
+  for (int h = 0; h < nh; h++)
+  {
+    if (twins[h] != Boundary)
+      continue;
+
+    int a = origin(h);
+    int b = target(h);
+
+    for (unsigned int i = edgeHash(b, a) & mask;; i = (i + 1) & mask)
+    {
+      int g = table[i];
+
+      if (g < 0)
+        break;
+      if (origin(g) == b && target(g) == a)
+      {
+        if (twins[g] == NonManifold)
+          twins[h] = NonManifold;
+        else
+        {
+          twins[h] = g;
+          twins[g] = h;
+        }
+        break;
+      }
+    }
+  }
+  delete []table;
+
+  // Choose the outgoing half-edge of each vertex, starting the
+  // fans of boundary vertices at the boundary
+  int* corners = new int[nv];
+
+  vertexEdges = new int[nv];
+  vertexFlags = new unsigned char[nv];
+  memset(vertexEdges, -1, nv * sizeof(int));
+  memset(vertexFlags, 0, nv);
+  memset(corners, 0, nv * sizeof(int));
+  for (int h = 0; h < nh; h++)
+  {
+    int v = origin(h);
+    int t = twins[h];
+
+    corners[v]++;
+    if (t == Boundary)
+    {
+      numberOfBoundaryEdges++;
+      vertexFlags[v] |= BoundaryVertex;
+    }
+    else if (t == NonManifold)
+    {
+      numberOfNonManifoldEdges++;
+      vertexFlags[v] |= NonManifoldVertex;
+      vertexFlags[target(h)] |= NonManifoldVertex;
+    }
+    if (vertexEdges[v] < 0 || (t < 0 && twins[vertexEdges[v]] >= 0))
+      vertexEdges[v] = h;
+  }
+  // A vertex is non-manifold if its first fan does not cover all
+  // of its corners
+  for (int v = 0; v < nv; v++)
+  {
+    int start = vertexEdges[v];
+
+    if (start < 0)
+      continue;
+
+    int n = 0;
+
+    for (int h = start;;)
+    {
+      n++;
+
+      int t = twins[prev(h)];
+
+      if (t < 0 || (h = t) == start)
+        break;
+    }
+    if (n != corners[v])
+      vertexFlags[v] |= NonManifoldVertex;
+    if (vertexFlags[v] & NonManifoldVertex)
+      numberOfNonManifoldVertices++;
+  }
+  delete []corners;
+}
+
+int
+TriangleMesh::HalfEdges::oneRing(int v, int* ring, int max) const
+//[]---------------------------------------------------[]
+//|  One-ring                                           |
+//[]---------------------------------------------------[]
+{
+  int start = vertexEdges[v];
+  int n = 0;
+
+  if (start < 0)
+    return 0;
+  for (int h = start; n < max;)
+  {
+    ring[n++] = target(h);
+
+    int t = twins[prev(h)];
+
+    if (t < 0)
+    {
+      // Open fan: add the last vertex of the last triangle
+      if (n < max)
+        ring[n++] = origin(prev(h));
+      break;
+    }
+    if ((h = t) == start)
+      break;
+  }
+  return n;
+}
+
+const TriangleMesh::HalfEdges&
+TriangleMesh::getHalfEdges() const
+//[]---------------------------------------------------[]
+//|  Half-edges                                         |
+//[]---------------------------------------------------[]
+{
+  if (halfEdges == 0)
+    halfEdges = new HalfEdges(data);
+  return *halfEdges;
+}
+
 void
-TriangleMesh::computeNormals()
+TriangleMesh::transform(const mat4& m)
+//[]---------------------------------------------------[]
+//|  Transform                                          |
+//|                                                     |
+//|  Bake an affine transformation into the vertices    |
+//|  and normals. The normals are transformed by the    |
+//|  inverse transposed of the 3x3 part of m; if m      |
+//|  mirrors the mesh, the triangles are flipped so     |
+//|  that they keep facing out.                         |
+//[]---------------------------------------------------[]
 {
   int nv = data.numberOfVertices;
 
-  if (data.normals == 0)
-    data.normals = new vec3[nv];
-  else if (data.numberOfNormals != nv)
+  if (nv == 0)
+    return;
+
+  vec3* vertices = editVertices();
+
+  transformPoints(m, vertices, vertices, nv);
+  if (data.normals != 0)
   {
-    delete []data.normals;
-    data.normals = new vec3[nv];
+    vec3* normals = editNormals();
+
+    transformNormals(normalMatrix(m), normals, normals, data.numberOfNormals);
   }
-  data.numberOfNormals = nv;
 
-  vec3* normals = data.normals;
-  Triangle* t = data.triangles;
+  mat3 r(m);
 
-  memset(normals, 0, nv * sizeof(vec3));
-  for (int i = 0; i < data.numberOfTriangles; i++, t++)
+  if (r[0].dot(r[1].cross(r[2])) < 0)
   {
-    int v0 = t->v[0];
-    int v1 = t->v[1];
-    int v2 = t->v[2];
-    vec3 N = triangleNormal(data.vertices, v0, v1, v2);
+    Triangle* t = editTriangles();
 
-    normals[v0] += N;
-    normals[v1] += N;
-    normals[v2] += N;
+    for (int i = 0, nt = data.numberOfTriangles; i < nt; i++)
+      t[i].setVertices(t[i].v[0], t[i].v[2], t[i].v[1]);
   }
-  for (int i = 0; i < nv; i++)
-    normals[i].normalize();
+}
+
+#define FACE_CHUNK 512
+
+//
+// Auxiliary functions
+//
+inline REAL
+angle(const vec3& a, const vec3& b)
+{
+  return (REAL)acos(dMax<REAL>(-1, dMin<REAL>(a.dot(b), 1)));
+}
+
+static void
+gatherCorners(const vec3* vertices,
+  const TriangleMesh::Triangle* triangles,
+  REAL* s,
+  int n)
+{
+  // The streams are x, y, and z of the first corner, then of the
+  // second and third, each one with FACE_CHUNK elements
+  for (int k = 0; k < 3; k++)
+    BatchKernel<REAL>::gather(vertices,
+      triangles->v + k,
+      3,
+      s + 3 * k * FACE_CHUNK,
+      FACE_CHUNK,
+      n);
+}
+
+static void
+cornerAngles(const REAL* s, REAL* w, int n)
+{
+  // Each edge is normalized only once
+  const int size = FACE_CHUNK;
+
+  for (int i = 0; i < n; i++)
+  {
+    const REAL* p = s + i;
+    const vec3 p0(p[0], p[size], p[2 * size]);
+    const vec3 p1(p[3 * size], p[4 * size], p[5 * size]);
+    const vec3 p2(p[6 * size], p[7 * size], p[8 * size]);
+    const vec3 e01 = (p1 - p0).versor();
+    const vec3 e02 = (p2 - p0).versor();
+    const vec3 e12 = (p2 - p1).versor();
+
+    w[3 * i] = angle(e01, e02);
+    w[3 * i + 1] = angle(e12, -e01);
+    w[3 * i + 2] = angle(e02, e12);
+  }
+}
+
+inline bool
+sameNormal(const vec3& a, const vec3& b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+void
+TriangleMesh::computeNormals(NormalWeighting weighting, REAL creaseAngle)
+//[]---------------------------------------------------[]
+//|  Compute normals                                    |
+//|                                                     |
+//|  The normal of a vertex is the weighted sum of the  |
+//|  normals of its incident triangles. The corners of  |
+//|  the triangles are gathered into streams (SoA), so  |
+//|  that the face normals are computed by a batch      |
+//|  kernel; the corner weights are computed in a       |
+//|  separate pass. Rather than scattering face normals |
+//|  into the vertices, each vertex gathers them        |
+//|  through a vertex-triangle adjacency, so that both  |
+//|  the face and the vertex loops can run in parallel. |
+//|                                                     |
+//|  If creaseAngle (in degrees) is less than 180, a    |
+//|  face contributes to a corner only if its normal    |
+//|  is within creaseAngle of the corner face normal.   |
+//|  Vertices whose corners end up with distinct        |
+//|  normals are split.                                 |
+//[]---------------------------------------------------[]
+{
+  int nv = data.numberOfVertices;
+  int nt = data.numberOfTriangles;
+  const vec3* vertices = data.vertices;
+  const Triangle* triangles = data.triangles;
+  vec3* faceNormals = new vec3[nt];
+  REAL* weights = new REAL[3 * nt];
+
+  // Compute the face normals and corner weights by chunks of
+  // triangles, whose corners are gathered into streams small
+  // enough to stay in cache for both passes
+#pragma omp parallel for
+  for (int i = 0; i < nt; i += FACE_CHUNK)
+  {
+    REAL s[9 * FACE_CHUNK];
+    REAL len[FACE_CHUNK];
+    REAL* w = weights + 3 * i;
+    int n = dMin(nt - i, FACE_CHUNK);
+
+    gatherCorners(vertices, triangles + i, s, n);
+    BatchKernel<REAL>::faceNormals(s, FACE_CHUNK, faceNormals + i, len, n);
+    switch (weighting)
+    {
+      case AreaWeighting:
+        for (int j = 0; j < n; j++)
+          w[3 * j] = w[3 * j + 1] = w[3 * j + 2] = len[j];
+        break;
+      case AngleWeighting:
+        cornerAngles(s, w, n);
+        break;
+      default:
+        for (int j = 0; j < 3 * n; j++)
+          w[j] = 1;
+    }
+  }
+
+  VertexTriangles vt(data);
+
+  if (creaseAngle < 180)
+  {
+    REAL cosCrease = (REAL)cos(Math::toRadians<REAL>(dMax<REAL>(creaseAngle, 0)));
+    vec3* cornerNormals = new vec3[3 * nt];
+    int* group = new int[3 * nt];
+
+    // Compute the normal of each corner, and the first corner of
+    // the same vertex with the same normal (the corner group)
+#pragma omp parallel for
+    for (int v = 0; v < nv; v++)
+      for (int i = vt.begin(v), e = vt.end(v); i < e; i++)
+      {
+        int c = vt.corners[i];
+        const vec3& Nc = faceNormals[c / 3];
+        vec3 N(0, 0, 0);
+
+        for (int j = vt.begin(v); j < e; j++)
+        {
+          int f = vt.corners[j];
+
+          if (Nc.dot(faceNormals[f / 3]) >= cosCrease)
+            N += faceNormals[f / 3] * weights[f];
+        }
+        cornerNormals[c] = N.normalize();
+        group[c] = c;
+        for (int j = vt.begin(v); j < i; j++)
+        {
+          int f = vt.corners[j];
+
+          if (sameNormal(cornerNormals[f], cornerNormals[c]))
+          {
+            group[c] = f;
+            break;
+          }
+        }
+      }
+
+    // Give a new vertex to every corner group but the first one
+    int* index = new int[3 * nt];
+    int n = nv;
+
+    for (int v = 0; v < nv; v++)
+      for (int i = vt.begin(v), e = vt.end(v); i < e; i++)
+      {
+        int c = vt.corners[i];
+
+        if (group[c] != c)
+          index[c] = index[group[c]];
+        else
+          index[c] = i == vt.begin(v) ? v : n++;
+      }
+    if (n > nv)
+    {
+      vec3* p = new vec3[n];
+      Color* colors = 0;
+
+      memcpy(p, vertices, nv * sizeof(vec3));
+      if (data.colors != 0 && data.numberOfColors == nv)
+      {
+        colors = new Color[n];
+        memcpy(colors, data.colors, nv * sizeof(Color));
+      }
+      for (int c = 0; c < 3 * nt; c++)
+        if (index[c] >= nv)
+        {
+          int v = triangles[c / 3].v[c % 3];
+
+          p[index[c]] = vertices[v];
+          if (colors != 0)
+            colors[index[c]] = data.colors[v];
+        }
+      // Remapping the triangles invalidates the vertex arrays,
+      // meshlets and half-edges of the mesh (if any)
+      Triangle* t = editTriangles();
+
+      for (int c = 0; c < 3 * nt; c++)
+        t[c / 3].v[c % 3] = index[c];
+      vertexBuffer = new ArrayBuffer<vec3>(data.vertices = p);
+      data.numberOfVertices = n;
+      streams = 0;
+      if (colors != 0)
+      {
+        colorBuffer = new ArrayBuffer<Color>(data.colors = colors);
+        data.numberOfColors = n;
+      }
+    }
+    if (data.normals == 0 || data.numberOfNormals != n)
+    {
+      normalBuffer = new ArrayBuffer<vec3>(data.normals = new vec3[n]);
+      data.numberOfNormals = n;
+    }
+
+    vec3* normals = editNormals();
+
+    for (int i = 0; i < n; i++)
+      normals[i] = vec3::null();
+    for (int c = 0; c < 3 * nt; c++)
+      normals[index[c]] = cornerNormals[c];
+    delete []index;
+    delete []group;
+    delete []cornerNormals;
+  }
+  else
+  {
+    if (data.normals == 0 || data.numberOfNormals != nv)
+    {
+      normalBuffer = new ArrayBuffer<vec3>(data.normals = new vec3[nv]);
+      data.numberOfNormals = nv;
+    }
+
+    vec3* normals = editNormals();
+
+#pragma omp parallel for
+    for (int v = 0; v < nv; v++)
+    {
+      vec3 N(0, 0, 0);
+
+      for (int i = vt.begin(v), e = vt.end(v); i < e; i++)
+      {
+        int c = vt.corners[i];
+        N += faceNormals[c / 3] * weights[c];
+      }
+      normals[v] = N.normalize();
+    }
+  }
+  delete []weights;
+  delete []faceNormals;
+}
+
+//
+// Auxiliary functions
+//
+inline vec3
+faceNormal(const vec3* p, const int v[3])
+{
+  return (p[v[1]] - p[v[0]]).cross(p[v[2]] - p[v[0]]);
+}
+
+static void
+computeMeshletBounds(TriangleMesh::Meshlet& m,
+  const vec3* p,
+  const TriangleMesh::Triangle* triangles,
+  const int* vertices)
+{
+  m.bounds.setEmpty();
+  for (int i = 0; i < m.numberOfVertices; i++)
+    m.bounds.inflate(p[vertices[i]]);
+  m.center = m.bounds.center();
+  m.radius = 0;
+  for (int i = 0; i < m.numberOfVertices; i++)
+    m.radius = dMax(m.radius, (p[vertices[i]] - m.center).length());
+
+  // The normal cone axis is the average of the triangle normals
+  vec3 axis = vec3::null();
+
+  triangles += m.firstTriangle;
+  for (int i = 0; i < m.numberOfTriangles; i++)
+  {
+    vec3 N = faceNormal(p, triangles[i].v);
+
+    if (!N.isNull())
+      axis += N.versor();
+  }
+  m.coneApex = m.center;
+  m.coneAxis = axis.versor();
+  m.coneCutoff = 2;
+  if (axis.isNull())
+    return;
+
+  REAL minDot = 1;
+
+  for (int i = 0; i < m.numberOfTriangles; i++)
+  {
+    vec3 N = faceNormal(p, triangles[i].v);
+
+    if (!N.isNull())
+      minDot = dMin(minDot, N.versor().dot(m.coneAxis));
+  }
+  // Cones wider than about 84 degrees are of no use for culling
+  if (minDot <= (REAL)0.1)
+    return;
+
+  // Move the apex back along the axis so that the cone contains
+  // the planes of all triangles
+  REAL maxT = 0;
+
+  for (int i = 0; i < m.numberOfTriangles; i++)
+  {
+    const int* v = triangles[i].v;
+    vec3 N = faceNormal(p, v);
+
+    if (!N.isNull())
+    {
+      N.normalize();
+      maxT = dMax(maxT, (m.center - p[v[0]]).dot(N) / N.dot(m.coneAxis));
+    }
+  }
+  m.coneApex = m.center - m.coneAxis * maxT;
+  m.coneCutoff = sqrt(1 - minDot * minDot);
+}
+
+TriangleMesh::Meshlets::Meshlets(Arrays& data,
+  int maxVertices,
+  int maxTriangles)
+//[]---------------------------------------------------[]
+//|  Constructor                                        |
+//|                                                     |
+//|  Greedy clustering: a meshlet grows by the adjacent |
+//|  triangle adding the fewest new vertices (the one   |
+//|  closest to the meshlet center on ties) until no    |
+//|  more triangles fit.                                |
+//[]---------------------------------------------------[]
+{
+  // Local vertex indices are bytes
+  maxVertices = dMax(3, dMin(maxVertices, 256));
+  maxTriangles = dMax(1, maxTriangles);
+
+  int nv = data.numberOfVertices;
+  int nt = data.numberOfTriangles;
+  VertexTriangles vt(data);
+  const Triangle* triangles = data.triangles;
+  const vec3* p = data.vertices;
+  bool* emitted = new bool[nt];
+  int* local = new int[nv];
+  Triangle* output = new Triangle[nt];
+  Meshlet* m = new Meshlet[nt];
+  int* v = new int[3 * nt];
+  int n = 0;
+  int no = 0;
+  int nm = 0;
+
+  indices = new unsigned char[3 * nt];
+  memset(emitted, 0, nt * sizeof(bool));
+  memset(local, -1, nv * sizeof(int));
+  for (int seed = 0; seed < nt; seed++)
+  {
+    if (emitted[seed])
+      continue;
+
+    Meshlet& meshlet = m[nm++];
+    int* mv = v + n;
+    vec3 sum = vec3::null();
+
+    meshlet.firstTriangle = no;
+    meshlet.numberOfTriangles = 0;
+    meshlet.firstVertex = n;
+    meshlet.numberOfVertices = 0;
+    for (int t = seed; t >= 0;)
+    {
+      emitted[t] = true;
+      for (int k = 0; k < 3; k++)
+      {
+        int i = triangles[t].v[k];
+
+        if (local[i] < 0)
+        {
+          local[i] = meshlet.numberOfVertices;
+          mv[meshlet.numberOfVertices++] = i;
+          sum += p[i];
+        }
+        indices[3 * no + k] = (unsigned char)local[i];
+      }
+      output[no++] = triangles[t];
+      if (++meshlet.numberOfTriangles == maxTriangles)
+        break;
+
+      vec3 c = sum * Math::inverse<REAL>(REAL(meshlet.numberOfVertices));
+      int bestExtra = 4;
+      REAL bestDistance = 0;
+
+      t = -1;
+      for (int i = 0; i < meshlet.numberOfVertices; i++)
+        for (int j = vt.begin(mv[i]), e = vt.end(mv[i]); j < e; j++)
+        {
+          int u = vt.corners[j] / 3;
+
+          if (emitted[u])
+            continue;
+
+          const int* w = triangles[u].v;
+          int extra = (local[w[0]] < 0) + (local[w[1]] < 0) + (local[w[2]] < 0);
+
+          if (meshlet.numberOfVertices + extra > maxVertices || extra > bestExtra)
+            continue;
+
+          REAL d = (triangleCenter(p[w[0]], p[w[1]], p[w[2]]) - c).normSquared();
+
+          if (extra < bestExtra || d < bestDistance)
+          {
+            t = u;
+            bestExtra = extra;
+            bestDistance = d;
+          }
+        }
+    }
+    for (int i = 0; i < meshlet.numberOfVertices; i++)
+      local[mv[i]] = -1;
+    n += meshlet.numberOfVertices;
+  }
+  memcpy(data.triangles, output, nt * sizeof(Triangle));
+  numberOfMeshlets = nm;
+  meshlets = new Meshlet[nm];
+  vertices = new int[n];
+  for (int i = 0; i < nm; i++)
+  {
+    meshlets[i] = m[i];
+    computeMeshletBounds(meshlets[i], p, data.triangles, v + m[i].firstVertex);
+  }
+  memcpy(vertices, v, n * sizeof(int));
+  delete []v;
+  delete []m;
+  delete []output;
+  delete []local;
+  delete []emitted;
+}
+
+bool
+TriangleMesh::Meshlet::isOutside(const mat4& m) const
+//[]---------------------------------------------------[]
+//|  Is outside                                         |
+//|                                                     |
+//|  The meshlet is outside if all corners of its box   |
+//|  are outside the same clipping plane.               |
+//[]---------------------------------------------------[]
+{
+  const vec3& a = bounds.getMin();
+  const vec3& b = bounds.getMax();
+  int out[6] = {0, 0, 0, 0, 0, 0};
+
+  for (int i = 0; i < 8; i++)
+  {
+    vec3 q(i & 1 ? b.x : a.x, i & 2 ? b.y : a.y, i & 4 ? b.z : a.z);
+    vec4 c = m.transform(vec4(q, 1));
+
+    out[0] += c.x < -c.w;
+    out[1] += c.x > +c.w;
+    out[2] += c.y < -c.w;
+    out[3] += c.y > +c.w;
+    out[4] += c.z < -c.w;
+    out[5] += c.z > +c.w;
+  }
+  for (int i = 0; i < 6; i++)
+    if (out[i] == 8)
+      return true;
+  return false;
+}
+
+void
+TriangleMesh::buildMeshlets(int maxVertices, int maxTriangles)
+//[]---------------------------------------------------[]
+//|  Build meshlets                                     |
+//[]---------------------------------------------------[]
+{
+  // The triangles are reordered
+  editTriangles();
+  meshlets = new Meshlets(data, maxVertices, maxTriangles);
 }
 
 void
@@ -12,6 +12,7 @@
 //  ========
 //  Source file for triangle mesh shape.
 
+#include "MeshSimplifier.h"
 #include "TriangleMeshShape.h"
 
 using namespace Graphics;
@@ -21,13 +22,32 @@ using namespace Graphics;
 //
 // TriangleMeshShape implementation
 // =================
+TriangleMeshShape::TriangleMeshShape(const TriangleMeshShape& shape):
+  Primitive(shape),
+  mesh(shape.mesh != 0 ? (TriangleMesh*)shape.mesh->clone() : 0),
+  bounds(shape.bounds),
+  numberOfLODs(shape.numberOfLODs)
+//[]---------------------------------------------------[]
+//|  Copy constructor                                   |
+//[]---------------------------------------------------[]
+{
+  for (int i = 0; i < numberOfLODs; i++)
+  {
+    lods[i] = shape.lods[i];
+    lodErrors[i] = shape.lodErrors[i];
+  }
+}
+
 Object*
 TriangleMeshShape::clone() const
 //[]---------------------------------------------------[]
 //|  Make copy                                          |
+//|                                                     |
+//|  The mesh is cloned, so its arrays are shared until |
+//|  either mesh is edited; the LODs are shared.        |
 //[]---------------------------------------------------[]
 {
-  return new TriangleMeshShape((TriangleMesh*)mesh->clone());
+  return new TriangleMeshShape(*this);
 }
 
 const TriangleMesh*
@@ -50,3 +70,63 @@ TriangleMeshShape::boundingBox() const
   b.transform(this->matrix);
   return b;
 }
+
+const TriangleMesh*
+TriangleMeshShape::lodMesh(int i) const
+//[]---------------------------------------------------[]
+//|  LOD mesh                                           |
+//[]---------------------------------------------------[]
+{
+  if (i <= 0 || numberOfLODs == 0)
+    return mesh;
+  return lods[dMin(i, numberOfLODs) - 1];
+}
+
+REAL
+TriangleMeshShape::lodError(int i) const
+//[]---------------------------------------------------[]
+//|  LOD error                                          |
+//[]---------------------------------------------------[]
+{
+  if (i <= 0 || numberOfLODs == 0)
+    return 0;
+  return lodErrors[dMin(i, numberOfLODs) - 1];
+}
+
+bool
+TriangleMeshShape::addLOD(TriangleMesh* lod, REAL error)
+//[]---------------------------------------------------[]
+//|  Add LOD                                            |
+//[]---------------------------------------------------[]
+{
+  if (lod == 0 || numberOfLODs == MAX_LODS)
+    return false;
+
+  REAL d = bounds.diagonalLength();
+
+  lods[numberOfLODs] = lod;
+  lodErrors[numberOfLODs++] = d > 0 ? error / d : 0;
+  return true;
+}
+
+int
+TriangleMeshShape::makeLODs(const REAL ratios[], int n)
+//[]---------------------------------------------------[]
+//|  Make LODs                                          |
+//|                                                     |
+//|  Ratios are fractions of the number of triangles of |
+//|  the full resolution mesh, in decreasing order.     |
+//[]---------------------------------------------------[]
+{
+  if (mesh == 0)
+    return 0;
+  n = dMin(n, MAX_LODS - numberOfLODs);
+
+  TriangleMesh* meshes[MAX_LODS];
+  REAL errors[MAX_LODS];
+
+  n = MeshSimplifier::makeLODs(*mesh, ratios, n, meshes, errors);
+  for (int i = 0; i < n; i++)
+    addLOD(meshes[i], errors[i]);
+  return n;
+}
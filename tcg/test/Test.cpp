@@ -0,0 +1,876 @@
+//[]------------------------------------------------------------------------[]
+//|                                                                          |
+//|                          GVSG Graphics Classes                           |
+//|                               Version 1.0                                |
+//|                                                                          |
+//|              Copyright 2007-2014, Paulo Aristarco Pagliosa              |
+//|              All Rights Reserved.                                        |
+//|                                                                          |
+//[]------------------------------------------------------------------------[]
+//
+//  OVERVIEW: Test.cpp
+//  ========
+//  Regression tests of the container, scene, mesh, and culling
+//  classes.
+//
+//  Usage: test
+//  Each failed check is reported; the exit code is the number of
+//  failed checks.
+
+#include <math.h>
+#include <stdio.h>
+#include "Array.h"
+#include "Camera.h"
+#include "ChunkedMesh.h"
+#include "List.h"
+#include "MeshSimplifier.h"
+#include "MeshSweeper.h"
+#include "OcclusionCuller.h"
+#include "Scene.h"
+#include "TriangleMeshShape.h"
+
+#define CHECK(c) check(c, #c, __FILE__, __LINE__)
+
+using namespace Graphics;
+using namespace System::Collections;
+
+int checks;
+int failures;
+
+//
+// Element type that counts its live instances
+//
+struct Counted
+{
+  static int live;
+  int value;
+
+  Counted(int v = 0):
+    value(v)
+  {
+    live++;
+  }
+
+  Counted(const Counted& c):
+    value(c.value)
+  {
+    live++;
+  }
+
+  Counted(Counted&& c):
+    value(c.value)
+  {
+    c.value = -1;
+    live++;
+  }
+
+  ~Counted()
+  {
+    live--;
+  }
+
+  Counted& operator =(const Counted& c)
+  {
+    value = c.value;
+    return *this;
+  }
+
+  Counted& operator =(Counted&& c)
+  {
+    value = c.value;
+    c.value = -1;
+    return *this;
+  }
+
+  bool operator ==(const Counted& c) const
+  {
+    return value == c.value;
+  }
+
+}; // Counted
+
+int Counted::live;
+
+//
+// Auxiliary functions
+//
+inline void
+check(bool ok, const char* what, const char* file, int line)
+{
+  checks++;
+  if (!ok)
+  {
+    printf("%s(%d): check failed: %s\n", file, line, what);
+    failures++;
+  }
+}
+
+inline Actor*
+makeActor(TriangleMesh* mesh, const vec3& p)
+{
+  Primitive* shape = new TriangleMeshShape(mesh);
+
+  shape->setTRS(p, quat::identity(), vec3(1, 1, 1));
+  return new Actor(*shape);
+}
+
+// Pseudo-random number in [a, b), the same sequence on every run
+inline REAL
+uniform(REAL a, REAL b)
+{
+  static unsigned int seed = 12345;
+
+  seed = seed * 1664525 + 1013904223;
+  return a + (b - a) * REAL(seed >> 8) / REAL(1 << 24);
+}
+
+// Check that the leaves reported by a query of an AABB tree are
+// the leaves whose boxes pass the test of the query, each one once
+template <typename P>
+bool
+sameLeaves(const AABBTree& tree, const int* leaves, int n,
+  const Array<int>& rows, P test)
+{
+  bool* found = new bool[n];
+  int count = 0;
+  bool ok = true;
+
+  for (int i = 0; i < n; i++)
+  {
+    found[i] = false;
+    if (test(tree.getBox(leaves[i])))
+      count++;
+  }
+  for (int k = 0; k < rows.size(); k++)
+  {
+    int i = rows[k];
+
+    if (i < 0 || i >= n || found[i] || !test(tree.getBox(leaves[i])))
+      ok = false;
+    else
+      found[i] = true;
+  }
+  delete []found;
+  return ok && rows.size() == count;
+}
+
+//
+// Tests
+//
+void
+testArrayGrowth()
+{
+  // The capacity grows geometrically, so that adding n elements
+  // reallocates O(log n) times, and the elements are kept
+  Array<int> a(2);
+  int reallocations = 0;
+
+  for (int i = 0; i < 1000; i++)
+  {
+    int capacity = a.getCapacity();
+
+    a.add(i);
+    if (a.getCapacity() != capacity)
+      reallocations++;
+  }
+  CHECK(a.size() == 1000 && a.getCapacity() >= 1000);
+  CHECK(reallocations <= 10);
+
+  bool ok = true;
+
+  for (int i = 0; i < 1000; i++)
+    ok &= a[i] == i;
+  CHECK(ok);
+
+  Array<int> b(std::move(a));
+
+  CHECK(a.size() == 0 && b.size() == 1000 && b[999] == 999);
+}
+
+void
+testArrayRemove()
+{
+  Array<int> a;
+
+  for (int i = 0; i < 8; i++)
+    a.add(i);
+  CHECK(a.removeAt(0) && a.size() == 7 && a[0] == 1);
+  CHECK(a.removeAt(3) && a.size() == 6 && a[3] == 5 && a[2] == 3);
+  CHECK(a.removeAt(5) && a.size() == 5 && a[4] == 6);
+  CHECK(!a.removeAt(5) && a.size() == 5);
+  a.addAt(4, 3);
+  CHECK(a.size() == 6 && a[3] == 4 && a[4] == 5);
+  CHECK(a.remove(4) && a.findIndex(4) < 0 && a.size() == 5);
+  CHECK(!a.remove(42));
+}
+
+void
+testArrayElements()
+{
+  // Non-trivially copyable elements are moved when the storage grows
+  // or elements are removed, and every element is destroyed once
+  {
+    Array<Counted> a(1);
+
+    for (int i = 0; i < 100; i++)
+      a.add(Counted(i));
+    CHECK(Counted::live == 100);
+    a.add(a[0]);
+    CHECK(Counted::live == 101 && a[100].value == 0);
+    CHECK(a.removeAt(0) && Counted::live == 100 && a[0].value == 1);
+    CHECK(a.removeAt(50) && Counted::live == 99 && a[50].value == 52);
+    a.addAt(Counted(51), 50);
+    CHECK(Counted::live == 100 && a[50].value == 51 && a[51].value == 52);
+
+    bool ok = true;
+
+    for (int i = 0; i < 99; i++)
+      ok &= a[i].value == i + 1;
+    CHECK(ok);
+    for (int i = 0; i < 10; i++)
+      a.removeAt(a.size() - 1);
+    CHECK(Counted::live == 90);
+    a.clear();
+    CHECK(Counted::live == 0 && a.isEmpty());
+    for (int i = 0; i < 10; i++)
+      a.add(Counted(i));
+  }
+  CHECK(Counted::live == 0);
+}
+
+void
+testSmallArray()
+{
+  // The first N elements are inside the array; more elements move
+  // all of them to the heap
+  {
+    SmallArray<Counted, 4> a;
+
+    for (int i = 0; i < 4; i++)
+      a.add(Counted(i));
+    CHECK(a.isSmall() && a.getCapacity() == 4 && Counted::live == 4);
+    a.add(Counted(4));
+    CHECK(!a.isSmall() && a.getCapacity() >= 5 && Counted::live == 5);
+
+    bool ok = true;
+
+    for (int i = 0; i < 5; i++)
+      ok &= a[i].value == i;
+    CHECK(ok);
+    a.add(a[0]);
+    CHECK(a.size() == 6 && a[5].value == 0 && Counted::live == 6);
+  }
+  CHECK(Counted::live == 0);
+}
+
+void
+testList()
+{
+  List<int> l;
+
+  for (int i = 0; i < 10; i++)
+    l.add(i);
+  l.addAtHead(-1);
+  CHECK(l.size() == 11 && l.contains(5));
+  CHECK(l.remove(5) && !l.contains(5) && l.size() == 10);
+  CHECK(!l.remove(5));
+  CHECK(l.removeHead() && !l.contains(-1));
+
+  int expected[] = {0, 1, 2, 3, 4, 6, 7, 8, 9};
+  int n = 0;
+  bool ok = true;
+
+  for (ListIterator<int> i(l.iterator()); i; i++)
+    ok &= n < 9 && i.current() == expected[n++];
+  CHECK(ok && n == 9);
+  l.clear();
+  CHECK(l.isEmpty() && l.size() == 0);
+  l.add(1);
+  CHECK(l.size() == 1 && l.contains(1));
+}
+
+void
+testListPool()
+{
+  // A node freed by a removal is the next one allocated, and the
+  // nodes of a list are freed by clear() and by the destructor
+  {
+    List<Counted> l;
+
+    for (int i = 0; i < 100; i++)
+      l.add(Counted(i));
+    CHECK(Counted::live == 100);
+
+    ListIterator<Counted> i(l.iterator());
+
+    while (i.current().value != 50)
+      i++;
+
+    Counted* node = &i.current();
+
+    CHECK(l.remove(Counted(50)));
+    CHECK(Counted::live == 99);
+    l.add(Counted(100));
+
+    ListIterator<Counted> j(l.iterator());
+
+    while (j.current().value != 100)
+      j++;
+    CHECK(&j.current() == node);
+    l.clear();
+    CHECK(Counted::live == 0);
+    for (int i = 0; i < 20; i++)
+      l.addAtHead(Counted(i));
+    CHECK(Counted::live == 20 && l.size() == 20);
+  }
+  CHECK(Counted::live == 0);
+  {
+    List<Counted, ListHeap<ListElement<Counted> > > l;
+
+    for (int i = 0; i < 10; i++)
+      l.add(Counted(i));
+    CHECK(l.remove(Counted(3)));
+    CHECK(Counted::live == 9);
+  }
+  CHECK(Counted::live == 0);
+}
+
+void
+testAABBTree()
+{
+  // Removed nodes are reused, sorted inserts keep the tree balanced,
+  // and the queries report the leaves passing their tests until
+  // told to stop
+  const int n = 1024;
+  AABBTree tree;
+  int leaves[n];
+  int maxLeaf = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    const REAL x = REAL(i);
+
+    leaves[i] = tree.insert(Bounds3(vec3(x, 0, 0), vec3(x + 0.5f, 0.5f, 0.5f)), i);
+  }
+  // The height of a balanced tree of 1024 leaves is between
+  // log2(1024) and 1.44 * log2(1024)
+  CHECK(tree.height() >= 10 && tree.height() <= 15);
+  tree.remove(leaves[5]);
+  CHECK(tree.insert(Bounds3(vec3(5, 0, 0), vec3(5.5f, 0.5f, 0.5f)), 5) == leaves[5]);
+  for (int i = 0; i < n; i++)
+    tree.remove(leaves[i]);
+  CHECK(tree.height() == -1);
+  // The 2n - 1 nodes of the new tree are taken from the free list
+  for (int i = n; i-- > 0;)
+  {
+    const REAL x = REAL(i);
+
+    leaves[i] = tree.insert(Bounds3(vec3(x, 0, 0), vec3(x + 0.5f, 0.5f, 0.5f)), i);
+    if (leaves[i] > maxLeaf)
+      maxLeaf = leaves[i];
+  }
+  CHECK(maxLeaf < 2 * n);
+  CHECK(tree.height() >= 10 && tree.height() <= 15);
+
+  const Bounds3 box(vec3(100.2f, -1, -1), vec3(110.7f, 1, 1));
+  const vec3 center(500, 0, 0);
+  const REAL radius = 3.3f;
+  // Clip space x = (x - 800) / 5, so the frustum spans [795, 805]
+  const Frustum frustum(mat4::TRS(vec3(-160, 0, 0), quat::identity(),
+    vec3(0.2f, 1, 1)));
+  const Ray ray(vec3(300, 3, 0.25f), vec3(1, -1, 0).versor());
+  Array<int> rows;
+  int calls = 0;
+  auto report = [&](int i) { rows.add(i); return true; };
+  auto stop = [&](int) { calls++; return false; };
+
+  tree.query(box, report);
+  CHECK(rows.size() == 11);
+  CHECK(sameLeaves(tree, leaves, n, rows,
+    [&](const Bounds3& b) { return b.intersect(box); }));
+  rows.clear();
+  tree.query(center, radius, report);
+  CHECK(rows.size() == 7);
+  CHECK(sameLeaves(tree, leaves, n, rows,
+    [&](const Bounds3& b) { return b.squaredDistance(center) <= radius * radius; }));
+  rows.clear();
+  tree.query(frustum, report);
+  CHECK(rows.size() >= 10);
+  CHECK(sameLeaves(tree, leaves, n, rows,
+    [&](const Bounds3& b) { return !frustum.isOutside(b); }));
+  rows.clear();
+  tree.query(ray, report);
+  CHECK(!rows.isEmpty());
+  CHECK(sameLeaves(tree, leaves, n, rows,
+    [&](const Bounds3& b) { REAL t; return b.intersect(ray, t); }));
+  tree.query(box, stop);
+  tree.query(center, radius, stop);
+  tree.query(frustum, stop);
+  tree.query(ray, stop);
+  CHECK(calls == 4);
+}
+
+void
+testFrustumPackets()
+{
+  // The packet test of a frustum (used by the renderer to cull four
+  // boxes at a time) agrees with the test of a single box, also in
+  // the last packet of a number of boxes which is not a multiple
+  // of four
+  Camera camera(Camera::Perspective, vec3(0, 0, 10), vec3(0, 0, -1),
+    vec3(0, 1, 0), 60);
+  const int n = 1001;
+  Bounds3* boxes = new Bounds3[n];
+  unsigned char* visible = new unsigned char[n];
+  int count = 0;
+  int mismatches = 0;
+
+  camera.setClippingPlanes(1, 40);
+  camera.updateView();
+
+  const Frustum frustum(camera.getViewProjectionMatrix());
+
+  for (int i = 0; i < n; i++)
+  {
+    const vec3 p(uniform(-40, 40), uniform(-40, 40), uniform(-40, 20));
+    const vec3 s(uniform(0, 4), uniform(0, 4), uniform(0, 4));
+
+    boxes[i] = Bounds3(p, p + s);
+    if (!frustum.isOutside(boxes[i]))
+      count++;
+  }
+  CHECK(count > 50 && count < n - 50);
+  CHECK(frustum.cull(boxes, n, visible) == count);
+  for (int i = 0; i < n; i++)
+    if (visible[i] != (frustum.isOutside(boxes[i]) ? 0 : 1))
+      mismatches++;
+  CHECK(mismatches == 0);
+  // Bits of the empty boxes of a partial packet are ignored
+  for (int i = 0; i + 3 <= n; i += 3)
+  {
+    Bounds3x4 packet;
+    int mask = 0;
+
+    for (int j = 0; j < 3; j++)
+    {
+      packet.set(j, boxes[i + j]);
+      if (!frustum.isOutside(boxes[i + j]))
+        mask |= 1 << j;
+    }
+    if ((frustum.intersect(packet) & 7) != mask)
+      mismatches++;
+  }
+  CHECK(mismatches == 0);
+  delete []visible;
+  delete []boxes;
+}
+
+void
+testOcclusionCuller()
+{
+  // A quad in front of the camera hides the boxes behind it, but
+  // not the boxes beside or in front of it, or crossing the near
+  // plane. The odd size of the buffer, which is not a multiple of
+  // four texels, exercises the padded rows and the odd levels of
+  // the pyramid
+  const int w = 101;
+  const int h = 51;
+  Camera camera(Camera::Perspective, vec3(0, 0, 10), vec3(0, 0, -1),
+    vec3(0, 1, 0), 60, REAL(w) / REAL(h));
+  OcclusionCuller culler(w, h);
+  TriangleMesh* cube = MeshSweeper::makeCube();
+  const REAL s = Math::inverse<REAL>(cube->boundingBox().getMax().x);
+  // The quad spans [-4, 4] x [-3, 3] at z = 0
+  const mat4 m = mat4::TRS(vec3::null(), quat::identity(),
+    vec3(4 * s, 3 * s, 0.01f * s));
+  const Bounds3 behind(vec3(-1, -1, -5), vec3(1, 1, -3));
+
+  camera.setClippingPlanes(1, 100);
+  camera.updateView();
+  CHECK(culler.getNumberOfLevels() == 8);
+  culler.begin(camera.getViewProjectionMatrix());
+  culler.end();
+  CHECK(!culler.isOccluded(behind));
+  culler.begin(camera.getViewProjectionMatrix());
+  culler.addOccluder(*cube, m);
+  culler.end();
+  CHECK(culler.getNumberOfTriangles() > 0);
+  CHECK(culler.getDepth(w / 2, h / 2) < 1);
+  CHECK(culler.getDepth(0, 0) == 1 && culler.getDepth(w - 1, h - 1) == 1);
+  CHECK(culler.getDepth(0, 0, culler.getNumberOfLevels() - 1) == 1);
+  CHECK(culler.isOccluded(behind));
+  CHECK(culler.isOccluded(Bounds3(vec3(3, 2, -2), vec3(3.5f, 2.5f, -1))));
+  // Beside, partly beside, and in front of the quad
+  CHECK(!culler.isOccluded(Bounds3(vec3(7, -0.5f, -5), vec3(8, 0.5f, -4))));
+  CHECK(!culler.isOccluded(Bounds3(vec3(-10, -1, -5), vec3(10, 1, -4))));
+  CHECK(!culler.isOccluded(Bounds3(vec3(-1, -1, 2), vec3(1, 1, 3))));
+  // The near plane is at z = 9
+  CHECK(!culler.isOccluded(Bounds3(vec3(-1, -1, 8.5f), vec3(1, 1, 9.5f))));
+  delete cube;
+}
+
+void
+testStaticActorMove()
+{
+  // A static actor moved through the matrix of its model must be
+  // found at its new position after the next update
+  TriangleMesh* sphere = MeshSweeper::makeSphere();
+  Scene* scene = Scene::New();
+  Actor* a = makeActor(sphere, vec3(0, 0, 0));
+  Actor* b = makeActor(sphere, vec3(10, 0, 0));
+  const ActorTable& table = scene->getActorTable();
+  Array<int> rows;
+  REAL distance;
+
+  System::makeUse(scene);
+  scene->addActor(a);
+  scene->addActor(b);
+  CHECK(!a->isDynamic());
+  a->getModel()->setTRS(vec3(50, 0, 0), quat::identity(), vec3(1, 1, 1));
+  scene->update();
+  CHECK(table.getMatrices()[0][3].x == 50);
+  CHECK(scene->boundingBox().getMax().x > 50);
+  CHECK(table.findRows(vec3(0, 0, 0), REAL(0.5), rows) == 0);
+  CHECK(table.findRows(vec3(50, 0, 0), REAL(0.5), rows) == 1);
+  CHECK(rows.size() == 1 && table.getActor(rows[0]) == a);
+  rows.clear();
+  CHECK(table.findRows(Bounds3(vec3(45, -5, -5), vec3(55, 5, 5)), rows) == 1);
+  CHECK(scene->pickActor(Ray(vec3(50, 0, 10), vec3(0, 0, -1)), distance) == a);
+  CHECK(scene->pickActor(Ray(vec3(0, 0, 10), vec3(0, 0, -1)), distance) == 0);
+  // The row of b is not refreshed by moving a
+  CHECK(table.getMatrices()[1][3].x == 10);
+  scene->release();
+}
+
+void
+testModifiedRows()
+{
+  // An update refreshes only the rows of the actors modified, or
+  // whose models were modified, since the last update, and the
+  // rows of the dynamic actors
+  TriangleMesh* sphere = MeshSweeper::makeSphere();
+  Scene* scene = Scene::New();
+  Primitive* shape = new TriangleMeshShape(sphere);
+  Actor* a = new Actor(*shape);
+  Actor* b = new Actor(*shape);
+  Actor* c = makeActor(sphere, vec3(10, 0, 0));
+  const ActorTable& table = scene->getActorTable();
+  const quat q = quat::identity();
+  const vec3 s(1, 1, 1);
+
+  System::makeUse(scene);
+  scene->addActor(a);
+  scene->addActor(b);
+  scene->addActor(c);
+  CHECK(scene->update() == 0);
+  // Both actors of a model are refreshed, once
+  shape->setTRS(vec3(0, 5, 0), q, s);
+  shape->setTRS(vec3(0, 20, 0), q, s);
+  CHECK(scene->update() == 2);
+  CHECK(table.getMatrices()[0][3].y == 20);
+  CHECK(table.getMatrices()[1][3].y == 20);
+  CHECK(table.getMatrices()[2][3].y == 0);
+  CHECK(scene->update() == 0);
+  c->setVisible(false);
+  CHECK(table.getFlags()[2].isSet(Actor::Visible));
+  CHECK(scene->update() == 1);
+  CHECK(!table.getFlags()[2].isSet(Actor::Visible));
+  c->setDynamic(true);
+  CHECK(scene->update() == 1);
+  CHECK(scene->update() == 1);
+  CHECK(scene->update() == 1);
+  c->setDynamic(false);
+  CHECK(scene->update() == 1);
+  CHECK(scene->update() == 0);
+  // A queued row moved by a removal is refreshed in its new place
+  c->getModel()->setTRS(vec3(30, 0, 0), q, s);
+  scene->deleteActor(a);
+  CHECK(table.size() == 2 && table.getActor(0) == c);
+  CHECK(scene->update() == 1);
+  CHECK(table.getMatrices()[0][3].x == 30);
+  // A deleted actor is no longer an actor of its model
+  shape->setTRS(vec3(0, 40, 0), q, s);
+  CHECK(scene->update() == 1);
+  CHECK(table.getMatrices()[1][3].y == 40);
+  scene->release();
+}
+
+void
+testActorHierarchy()
+{
+  // Moving an actor moves its descendants, and only them, after
+  // the next update
+  TriangleMesh* sphere = MeshSweeper::makeSphere();
+  Scene* scene = Scene::New();
+  Actor* r = makeActor(sphere, vec3(10, 0, 0));
+  Actor* c = makeActor(sphere, vec3(0, 5, 0));
+  Actor* g = makeActor(sphere, vec3(0, 0, 2));
+  Actor* o = makeActor(sphere, vec3(100, 0, 0));
+  const ActorTable& table = scene->getActorTable();
+  const mat4* m;
+  Array<int> rows;
+
+  System::makeUse(scene);
+  scene->addActor(r);
+  scene->addActor(c);
+  scene->addActor(g);
+  scene->addActor(o);
+  m = table.getMatrices();
+  CHECK(c->setParent(r) && g->setParent(c));
+  CHECK(!r->setParent(g));
+  CHECK(scene->update() == 2);
+  CHECK(m[1][3] == vec4(10, 5, 0, 1));
+  CHECK(m[2][3] == vec4(10, 5, 2, 1));
+  r->getModel()->setTRS(vec3(20, 0, 0), quat::identity(), vec3(1, 1, 1));
+  CHECK(scene->update() == 1);
+  CHECK(m[2][3] == vec4(20, 5, 2, 1));
+  CHECK(m[3][3] == vec4(100, 0, 0, 1));
+  CHECK(table.findRows(vec3(20, 5, 2), REAL(0.5), rows) == 1);
+  CHECK(rows.size() == 1 && table.getActor(rows[0]) == g);
+  CHECK(table.findRows(vec3(10, 5, 2), REAL(0.5), rows) == 0);
+  // The children of a deleted actor become roots
+  scene->deleteActor(c);
+  scene->update();
+  CHECK(table.getActor(1) == o && table.getActor(2) == g);
+  CHECK(m[1][3] == vec4(100, 0, 0, 1));
+  CHECK(m[2][3] == vec4(0, 0, 2, 1));
+  scene->release();
+}
+
+void
+testChunkCache()
+{
+  // The cache size is not limited to 2 GB, and a cache holding the
+  // chunks in the view frustum hits them all from the second frame
+  // on, as the renderer requests only those chunks
+  const char* fileName = "test.chunks";
+  TriangleMesh* sphere = MeshSweeper::makeSphere(vec3::null(), 1, 64);
+  const int64 size = int64(3) << 30;
+
+  CHECK(ChunkedMesh::write(fileName, *sphere, 256));
+
+  ChunkedMesh* mesh = ChunkedMesh::open(fileName, size);
+
+  CHECK(mesh != 0);
+  if (mesh == 0)
+    return;
+  System::makeUse(mesh);
+  CHECK(mesh->getCacheSize() == size);
+
+  Camera camera;
+
+  camera.setPosition(vec3(0, 0, 5));
+  camera.setDirectionOfProjection(vec3(-1, 0, -4));
+  camera.setViewAngle(20);
+  camera.updateView();
+
+  Frustum frustum(camera.getViewProjectionMatrix());
+  int n = mesh->getNumberOfChunks();
+  int visible = 0;
+  int64 visibleSize = 0;
+
+  for (int i = 0; i < n; i++)
+    if (!frustum.isOutside(mesh->chunkBounds(i)))
+    {
+      visible++;
+      visibleSize += mesh->getChunkInfo(i).size;
+    }
+  CHECK(visible > 0 && visible < n);
+  mesh->setCacheSize(visibleSize);
+  for (int frame = 0; frame < 2; frame++)
+    for (int i = 0; i < n; i++)
+      if (!frustum.isOutside(mesh->chunkBounds(i)))
+        CHECK(mesh->getChunk(i) != 0);
+  CHECK(mesh->getStatistics().misses == visible);
+  CHECK(mesh->getStatistics().hits == visible);
+  mesh->release();
+  delete sphere;
+  remove(fileName);
+}
+
+bool
+patchFile(const char* fileName, long offset, int value)
+{
+  FILE* file = fopen(fileName, "r+b");
+  bool ok = file != 0 &&
+    fseek(file, offset, SEEK_SET) == 0 &&
+    fwrite(&value, sizeof(int), 1, file) == 1;
+
+  if (file != 0)
+    fclose(file);
+  return ok;
+}
+
+void
+testCorruptChunkFile()
+{
+  // Counts read from a chunked mesh file that do not fit in the file
+  // fail the open instead of being allocated
+  const char* fileName = "test.chunks";
+  TriangleMesh* sphere = MeshSweeper::makeSphere(vec3::null(), 1, 16);
+  const long chunkCount = 4 + 3 * sizeof(int);
+  const long directory = 4 + 4 * sizeof(int) + 2 * sizeof(vec3);
+  const long vertexCount = directory + 2 * sizeof(vec3) + sizeof(int64);
+  ChunkedMesh* mesh;
+
+  CHECK(ChunkedMesh::write(fileName, *sphere, 64));
+  CHECK((mesh = ChunkedMesh::open(fileName)) != 0);
+
+  int nc = mesh != 0 ? mesh->getNumberOfChunks() : 0;
+  int nv = mesh != 0 ? mesh->getChunkInfo(0).numberOfVertices : 0;
+
+  System::release(mesh);
+  CHECK(patchFile(fileName, chunkCount, 0x7fffffff));
+  CHECK(ChunkedMesh::open(fileName) == 0);
+  CHECK(patchFile(fileName, chunkCount, nc));
+  CHECK(patchFile(fileName, vertexCount, 0x7fffffff));
+  CHECK(ChunkedMesh::open(fileName) == 0);
+  CHECK(patchFile(fileName, vertexCount, -1));
+  CHECK(ChunkedMesh::open(fileName) == 0);
+  CHECK(patchFile(fileName, vertexCount, nv));
+  CHECK((mesh = ChunkedMesh::open(fileName)) != 0);
+  if (mesh != 0)
+  {
+    CHECK(mesh->getChunk(0) != 0);
+    mesh->release();
+  }
+  delete sphere;
+  remove(fileName);
+}
+
+void
+testSharedHalfEdges()
+{
+  // The half-edges are shared with the clones and rebuilt only by a
+  // mesh whose triangles are edited
+  TriangleMesh* mesh = MeshSweeper::makeSphere(vec3::null(), 1, 16);
+  const TriangleMesh::HalfEdges* edges = &mesh->getHalfEdges();
+  TriangleMesh* copy = (TriangleMesh*)mesh->clone();
+
+  CHECK(&copy->getHalfEdges() == edges);
+  copy->editVertices();
+  CHECK(&copy->getHalfEdges() == edges);
+  copy->editTriangles();
+  CHECK(&copy->getHalfEdges() != edges);
+  CHECK(copy->getHalfEdges().isClosed());
+  CHECK(&mesh->getHalfEdges() == edges);
+  delete copy;
+  CHECK(mesh->getHalfEdges().isClosed());
+  delete mesh;
+}
+
+void
+testEditColors()
+{
+  // Editing the colors drops the GL vertex arrays (user data) of the
+  // mesh, as editing the vertices does, but not the ones of a clone
+  TriangleMesh* mesh = MeshSweeper::makeSphere(vec3::null(), 1, 16);
+  int nv = mesh->getData().numberOfVertices;
+
+  mesh->setColors(new Color[nv], nv);
+  mesh->userData = mesh->clone();
+
+  TriangleMesh* copy = (TriangleMesh*)mesh->clone();
+
+  CHECK(copy->userData == mesh->userData);
+  copy->editColors()[0] = Color::black;
+  CHECK(copy->userData == 0);
+  CHECK(mesh->userData != 0);
+  CHECK(mesh->getData().colors != copy->getData().colors);
+  delete copy;
+  delete mesh;
+}
+
+TriangleMesh*
+makeWavyDisk(int n)
+{
+  // Planar n x n grid whose boundary vertices are moved in the plane,
+  // so that the boundary constraints of the simplifier are not null
+  TriangleMesh::Block* block =
+    TriangleMesh::Block::New(n * n, 0, 2 * (n - 1) * (n - 1), 0);
+  TriangleMesh::Arrays a = block->getArrays();
+
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++)
+    {
+      vec3 p(REAL(i), REAL(j), 0);
+
+      if (i == 0 || j == 0 || i == n - 1 || j == n - 1)
+        p += vec3(REAL(0.3) * sin(REAL(j)), REAL(0.3) * sin(REAL(i)), 0);
+      a.vertices[j * n + i] = p;
+    }
+
+  TriangleMesh::Triangle* t = a.triangles;
+
+  for (int j = 0; j < n - 1; j++)
+    for (int i = 0; i < n - 1; i++, t += 2)
+    {
+      int v = j * n + i;
+
+      t[0].setVertices(v, v + 1, v + n + 1);
+      t[1].setVertices(v, v + n + 1, v + n);
+    }
+  return new TriangleMesh(block);
+}
+
+void
+testSimplifierError()
+{
+  // The error of a planar mesh is null, whatever its boundary
+  TriangleMesh* disk = makeWavyDisk(32);
+  int nt = disk->getData().numberOfTriangles;
+  REAL error = -1;
+  TriangleMesh* lod = MeshSimplifier::execute(*disk, nt / 32, &error);
+
+  CHECK(lod != 0);
+  if (lod != 0)
+    CHECK(lod->getData().numberOfTriangles <= nt / 32);
+  CHECK(error >= 0 && error < REAL(1e-3));
+  delete lod;
+  delete disk;
+
+  // The error bounds the distance of the vertices to a sphere
+  TriangleMesh* sphere = MeshSweeper::makeSphere(vec3::null(), 1, 64);
+
+  nt = sphere->getData().numberOfTriangles;
+  lod = MeshSimplifier::execute(*sphere, nt / 8, &error);
+  CHECK(lod != 0 && error > 0);
+  if (lod != 0)
+  {
+    const TriangleMesh::Arrays& a = lod->getData();
+    REAL d = 0;
+
+    for (int i = 0; i < a.numberOfVertices; i++)
+      d = dMax(d, fabs(1 - a.vertices[i].length()));
+    CHECK(d <= error);
+  }
+  delete lod;
+  delete sphere;
+}
+
+//
+// Main function
+//
+int
+main()
+{
+  testArrayGrowth();
+  testArrayRemove();
+  testArrayElements();
+  testSmallArray();
+  testList();
+  testListPool();
+  testAABBTree();
+  testFrustumPackets();
+  testOcclusionCuller();
+  testStaticActorMove();
+  testModifiedRows();
+  testActorHierarchy();
+  testChunkCache();
+  testCorruptChunkFile();
+  testSharedHalfEdges();
+  testEditColors();
+  testSimplifierError();
+  printf("%d checks, %d failed\n", checks, failures);
+  return failures;
+}